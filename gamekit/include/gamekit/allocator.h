@@ -0,0 +1,111 @@
+/*
+ * Allocator
+ */
+#pragma once
+
+#include <vulkan>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory Block
+///////////////////////////////////////////////////////////////////////////////
+
+class MemoryBlock {
+
+    friend class MemoryAllocator;
+
+    private:
+        struct Range {
+            size_t offset{0};
+            size_t size{0};
+        };
+
+    public:
+        [[nodiscard]] VkDeviceMemory ptr() const { return handle_; }
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] size_t used() const { return used_; }
+        [[nodiscard]] void* mapped() const { return mapped_; }
+        [[nodiscard]] uint32_t typeIndex() const { return typeIndex_; }
+        [[nodiscard]] bool empty() const { return 0 == used_; }
+
+    private:
+        bool alloc(size_t size, size_t alignment, size_t& offset);
+        void free(size_t offset, size_t size);
+
+    private:
+        VkDeviceMemory handle_{nullptr};
+        size_t size_{0};
+        size_t used_{0};
+        void* mapped_{nullptr};
+        uint32_t typeIndex_{0};
+        bool linear_{true};
+        std::vector<Range> freeList_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory Allocator
+///////////////////////////////////////////////////////////////////////////////
+
+class MemoryAllocator {
+
+    public:
+        static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    public:
+        struct Allocation {
+            VkDeviceMemory memory{nullptr};
+            MemoryBlock* block{nullptr};
+            size_t offset{0};
+            size_t size{0};
+            void* mapped{nullptr};
+        };
+
+        struct Statistics {
+            size_t blockCount{0};
+            size_t dedicatedCount{0};
+            size_t allocationCount{0};
+            size_t reservedSize{0};
+            size_t usedSize{0};
+        };
+
+    public:
+        MemoryAllocator() {}
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+        ~MemoryAllocator() { destroy(); }
+
+    public:
+        void create(VkPhysicalDevice physicalDevice, VkDevice device, size_t blockSize=DEFAULT_BLOCK_SIZE);
+        void destroy();
+
+    public:
+        [[nodiscard]] Allocation alloc(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags propertyFlags, bool linear);
+        void free(const Allocation& allocation);
+        [[nodiscard]] uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propertyFlags) const;
+
+    public:
+        [[nodiscard]] const VkPhysicalDeviceMemoryProperties& memoryProperties() const { return memoryProperties_; }
+        [[nodiscard]] size_t blockSize() const { return blockSize_; }
+        [[nodiscard]] Statistics statistics() const;
+
+    private:
+        VkDeviceMemory allocMemory(size_t size, uint32_t typeIndex, void** mapped);
+        void freeMemory(VkDeviceMemory memory, void* mapped);
+        [[nodiscard]] bool isHostVisible(uint32_t typeIndex) const;
+
+    private:
+        VkDevice device_{nullptr};
+        VkPhysicalDeviceMemoryProperties memoryProperties_{};
+        size_t blockSize_{DEFAULT_BLOCK_SIZE};
+        size_t allocationCount_{0};
+        size_t dedicatedCount_{0};
+        std::vector<std::unique_ptr<MemoryBlock>> blocks_;
+        mutable std::mutex mutex_;
+};
+
+} // namespace
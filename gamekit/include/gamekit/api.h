@@ -8,8 +8,12 @@
 
 #include "gamekit/metrics.h"
 #include "gamekit/material.h"
+#include "gamekit/compute.h"
+#include "gamekit/render_queue.h"
+#include "gamekit/texture_table.h"
 #include "gamekit/frame.h"
 #include "gamekit/resources.h"
+#include "gamekit/profiler.h"
 
 namespace gamekit {
 
@@ -25,18 +29,29 @@ class Api {
     public:
         float deltaTime() const;
         float absTime() const;
+        float interpolation() const;   // fixed timestep, see ApplicationBase::setFixedTimestep
 
         void addMaterial(Material& material);
         void setMaterial(Material* material);
         Material* material();
 
+        void addComputeMaterial(ComputeMaterial& computeMaterial);
+
+        RenderQueue& renderQueue();
+        TextureTable& textureTable();
+        bool isBindlessSupported() const;
+
         const Metrics& metrics() const;
 
         const Frame& currentFrame() const;
 
+        const std::vector<GpuProfiler::Result>& gpuTimings() const;
+        double gpuFrameTime() const;
+
         Resources& resources();
         const Resources& resources() const;
         const ResourceDescriptor& resources(const std::string& id) const;
+        const ResourceDescriptor& resources(ResourceId id) const;
 
     private:
         Context* context_{nullptr};
@@ -4,17 +4,26 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
 
 #include "gamekit/device.h"
 #include "gamekit/window.h"
 #include "gamekit/resources.h"
 #include "gamekit/types.h"
 #include "gamekit/api.h"
+#include "gamekit/benchmark.h"
 
 namespace gamekit {
 
 class ApplicationBase {
 
+    public:
+        static const int DEFAULT_MAX_STEPS = 5;    // fixed timestep catch-up limit per advance
+
     private:
         static ApplicationBase* global_instance_;
 
@@ -27,17 +36,45 @@ class ApplicationBase {
 
     public:
         virtual void run();
+        void configure(int argc, const char* argv[]);
+
+    public:
+        void setHeadless(bool headless) { headless_ = headless; }
+        void setFrameLimit(size_t frameLimit) { frameLimit_ = frameLimit; }
+        void setCaptureFile(const std::string& filename) { captureFile_ = filename; }
+        void setBenchmark(size_t frameCount, const std::string& jsonFile="");
+        [[nodiscard]] const Benchmark& benchmark() const { return benchmark_; }
+        [[nodiscard]] bool isBenchmark() const { return benchmarkFrames_ > 0; }
+        [[nodiscard]] bool isHeadless() const { return headless_; }
+
+    public:
+        // onUpdate runs at tickRate with a constant deltaTime, onDraw blends the last two
+        // ticks by interpolation(). a tick rate of zero restores one update per frame
+        void setFixedTimestep(int tickRate, int maxSteps=DEFAULT_MAX_STEPS);
+        // fixed timestep only: ticks run on their own thread, never concurrently with
+        // onDraw. onUpdate must then leave device and buffer access to onDraw
+        void setSimulationThread(bool simulationThread) { simulationThread_ = simulationThread; }
+        [[nodiscard]] bool isFixedTimestep() const { return tickTime_ > 0; }
+        [[nodiscard]] bool isSimulationThread() const { return simulationThread_; }
 
     private:
         void init();
         void shutdown();
         void update();
         void draw();
+        void advance(microsecond_t now);
+        void startSimulation();
+        void stopSimulation();
+        void simulate();
         void updateStatistics();
+        void capture();
+        void runBenchmarkFrame();
 
     public:
         inline float deltaTime() const { return deltaTime_; }
         inline float absTime() const { return absTime_; }
+        inline float interpolation() const { return interpolation_; }    // 0..1 past the last tick
+        inline uint64_t tickCount() const { return tickCount_; }
 
     protected:
         virtual void createResources() {}
@@ -70,10 +107,31 @@ class ApplicationBase {
         Device device;
         Statistics stats;
         bool running_{false};
+        bool headless_{false};
+        size_t frameLimit_{0};
+        size_t frameCounter_{0};
+        std::string captureFile_;
+        Benchmark benchmark_;
+        size_t benchmarkFrames_{0};
+        uint64_t benchmarkGpuFrames_{0};
+        std::string benchmarkFile_;
         float deltaTime_{0.0f};
         float absTime_{0.0f};
         Resources resources_;
 
+    private: // fixed timestep
+        microsecond_t tickTime_{0};
+        int maxSteps_{DEFAULT_MAX_STEPS};
+        microsecond_t accumulator_{0};
+        microsecond_t lastAdvance_{0};
+        uint64_t tickCount_{0};
+        float interpolation_{1.0f};
+        bool simulationThread_{false};
+        std::thread simulation_;
+        std::mutex simulationMutex_;    // held by ticks and onDraw
+        std::atomic<bool> simulating_{false};
+        std::exception_ptr simulationError_;
+
 };
 
 template <
@@ -90,6 +148,9 @@ class Application : public ApplicationBase {
         void createResources() override {
             auto resourceDescriptors = get_resource_descriptor_fn();
             resources_.create(resourceDescriptors);
+#ifdef GAMEKIT_RESOURCE_FOLDER
+            resources_.watch(GAMEKIT_RESOURCE_FOLDER); // development builds, see GAMEKIT_HOT_RELOAD
+#endif
         }
 
         void destroyResources() override {
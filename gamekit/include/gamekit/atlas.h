@@ -0,0 +1,57 @@
+/*
+ * Atlas
+ */
+#pragma once
+
+#include "gamekit/primitives.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Atlas
+///////////////////////////////////////////////////////////////////////////////
+
+// frame table of the texture atlas pages packed by gamekitc
+class Atlas {
+
+    public:
+        static const size_t npos = (size_t) -1;
+
+        struct Page {
+            std::string name;       // bitmap resource of the page
+            uint32_t width{0};
+            uint32_t height{0};
+        };
+
+        struct Frame {
+            uint32_t page{0};
+            glm::vec4 texcoords{0.0f, 0.0f, 1.0f, 1.0f};   // x, y, w, h in page uv space
+            glm::vec2 size{0.0f, 0.0f};                     // in pixels
+        };
+
+    public:
+        static Atlas make(const ResourceDescriptor& resourceDescriptor);
+        void create(const ResourceDescriptor& resourceDescriptor);
+
+    public:
+        [[nodiscard]] size_t frameIndex(const std::string& name) const;   // npos if not found
+        [[nodiscard]] const Frame* find(const std::string& name) const;
+        [[nodiscard]] const Frame& get(const std::string& name) const;
+        [[nodiscard]] const Frame& frame(size_t index) const { return frames_[index]; }
+        [[nodiscard]] size_t frameCount() const { return frames_.size(); }
+        [[nodiscard]] const Page& page(size_t index) const { return pages_[index]; }
+        [[nodiscard]] size_t pageCount() const { return pages_.size(); }
+
+    private:
+        std::vector<Page> pages_;
+        std::vector<Frame> frames_;
+        std::unordered_map<std::string, size_t> index_;
+};
+
+} // namespace
@@ -0,0 +1,66 @@
+/*
+ * Benchmark
+ */
+#pragma once
+
+#include "gamekit/primitives.h"
+
+#include <string>
+#include <vector>
+#include <array>
+#include <ostream>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmark
+///////////////////////////////////////////////////////////////////////////////
+
+class Benchmark {
+
+    public:
+        enum Phase {
+            Update = 0,
+            BeginDraw = 1,
+            Draw = 2,
+            EndDraw = 3,
+            Frame = 4,
+            GpuFrame = 5,
+            PhaseCount = 6
+        };
+
+        struct Summary {
+            size_t count{0};
+            double min{0.0};
+            double max{0.0};
+            double mean{0.0};
+            double median{0.0};
+            double p95{0.0};
+            double p99{0.0};
+        };
+
+    public:
+        void create(size_t frameCount);
+        void reset();
+
+    public:
+        void record(Phase phase, nanosecond_t duration);
+        void endFrame() { frameCounter_++; }
+
+    public:
+        [[nodiscard]] size_t frameCount() const { return frameCounter_; }
+        [[nodiscard]] const std::vector<nanosecond_t>& samples(Phase phase) const { return samples_[phase]; }
+        [[nodiscard]] Summary summary(Phase phase) const;
+        [[nodiscard]] static const char* phaseName(Phase phase);
+
+    public:
+        void print(std::ostream& out) const;
+        [[nodiscard]] std::string toJson() const;
+        bool writeJson(const std::string& filename) const;
+
+    private:
+        std::array<std::vector<nanosecond_t>, PhaseCount> samples_;
+        size_t frameCounter_{0};
+};
+
+} // namespace
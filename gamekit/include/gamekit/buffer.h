@@ -59,6 +59,10 @@ class BufferObject {
         void copy(const BufferObject& source, size_t len) const;
         void copy(const BufferObject& source) const;
 
+    public:
+        void* mapPersistent();
+        [[nodiscard]] void* mapped() const { return mapped_; }
+
     public:
         [[nodiscard]] VkBuffer ptr() { return handle_; };
         [[nodiscard]] const VkBuffer ptr() const { return handle_; };
@@ -70,6 +74,7 @@ class BufferObject {
         size_t size_{0};
         VkBuffer handle_{nullptr};
         DeviceMemory memory_;
+        void* mapped_{nullptr};
 };
 
 
@@ -84,6 +89,8 @@ class Buffer {
             None = 0x0,
             TransferSource = 0x100,
             TransferDest = 0x200,
+            Streaming = 0x400,
+            DeviceLocal = 0x800
         };
 
     protected:
@@ -129,11 +136,17 @@ class VertexBuffer : public Buffer {
 
     public:
         static VertexBuffer make(size_t size);
+        static VertexBuffer makeStreaming(size_t size);
 
     public:
         void copy(const void* sourcePtr);
         void copy(const void* sourcePtr, size_t len);
         void bind() const override;
+
+    public:
+        [[nodiscard]] VkBuffer handle() const;  // buffer of the current frame when streaming
+        [[nodiscard]] bool isStreaming() const { return 0x0 != (flags_ & Streaming); }
+        [[nodiscard]] void* data(size_t frameIndex) const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -148,6 +161,9 @@ class IndexBuffer : public Buffer {
     public:
         void copy(const void* sourcePtr);
         void bind() const override;
+
+    public:
+        [[nodiscard]] VkBuffer handle() const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -164,7 +180,7 @@ class UniformBuffer : public Buffer {
         void bind() const override;
 
     public:
-        [[nodiscard]] BufferObject& allocFrameBuffer();
+        [[nodiscard]] BufferObject& allocFrameBuffer(size_t frameIndex);
 };
 
 template <class T>
@@ -198,13 +214,15 @@ class ShaderStorageBuffer : public Buffer {
 
     public:
         static ShaderStorageBuffer make(uint32_t index, size_t size);
+        static ShaderStorageBuffer makeDeviceLocal(uint32_t index, size_t size);
 
     public:
         void copy(const void* sourcePtr);
         void bind() const override;
 
     public:
-        [[nodiscard]] BufferObject& allocFrameBuffer();
+        [[nodiscard]] BufferObject& allocFrameBuffer(size_t frameIndex);
+        [[nodiscard]] bool isDeviceLocal() const { return 0x0 != (flags_ & DeviceLocal); }
 };
 
 template <class T>
@@ -218,7 +236,7 @@ class ShaderStorage : public ShaderStorageBuffer {
 
     public:
         void copy() {
-            ShaderStorage::copy(&data_);
+            ShaderStorageBuffer::copy(&data_);
         }
 
     public:
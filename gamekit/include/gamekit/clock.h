@@ -15,6 +15,7 @@ class Clock {
     public:
         static void sleep(microsecond_t micros);
         static microsecond_t getTime();
+        static nanosecond_t getTimeNs();
 
     private:
         static microsecond_t time_offset;
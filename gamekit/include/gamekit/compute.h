@@ -0,0 +1,69 @@
+/*
+ * Compute
+ */
+#pragma once
+
+#include "gamekit/types.h"
+#include "gamekit/buffer.h"
+#include "gamekit/pipeline.h"
+
+#include <vulkan>
+#include <vector>
+#include <array>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Compute Material
+///////////////////////////////////////////////////////////////////////////////
+
+class ComputeMaterial {
+
+    public:
+        static ComputeMaterial make();
+
+    private:
+        void create();
+        void update();
+        void createComputePipeline();
+        void freeComputePipeline();
+        void createDescriptorSets();
+        void freeDescriptorSets();
+        DescriptorSet createDescriptorSet(size_t frameIndex);
+
+    public:
+        void compile();
+        void dispatch();    // recorded into the current frame ahead of the render pass
+        void destroy();
+
+    public:
+        const Shader* setShader(const Shader& shader);
+        const Buffer* addBuffer(Buffer& buffer);
+        void invalidate(const Shader& shader);  // replaced in place, the device is idle
+
+    public: // setters
+        void setGroupCount(uint32_t x, uint32_t y=1, uint32_t z=1) { groupCount_ = { x, y, z }; }
+        void setWorkSize(size_t numItems, uint32_t localSize) {
+            setGroupCount(static_cast<uint32_t>((numItems + localSize - 1) / localSize));
+        }
+
+    public: // getters
+        [[nodiscard]] const std::array<uint32_t, 3>& groupCount() const { return groupCount_; }
+        [[nodiscard]] const DescriptorPool& descriptorPool() { return descriptorPool_; }
+
+    private:
+        bool modified_{false};
+        DescriptorPool descriptorPool_;
+        const PipelineRegistry::Pipeline* pipeline_{nullptr};   // shared, owned by the device registry
+        std::vector<DescriptorSet> descriptorSets_;
+
+    private:
+        const Shader* shader_{nullptr};
+        std::vector<Buffer*> buffers_;
+        size_t numUniformBuffers_{0};
+        size_t numStorageBuffers_{0};
+        std::array<uint32_t, 3> groupCount_{0, 0, 0};
+
+};
+
+} // namespace
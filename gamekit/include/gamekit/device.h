@@ -10,6 +10,14 @@
 #include "gamekit/texture.h"
 #include "gamekit/frame.h"
 #include "gamekit/material.h"
+#include "gamekit/compute.h"
+#include "gamekit/transfer.h"
+#include "gamekit/allocator.h"
+#include "gamekit/profiler.h"
+#include "gamekit/pipeline.h"
+#include "gamekit/thread_pool.h"
+#include "gamekit/render_queue.h"
+#include "gamekit/texture_table.h"
 
 #include <vulkan>
 
@@ -56,6 +64,7 @@ class Device {
 
     public:
         void createDevice(Window& window, bool enableErrorChecking);
+        void createHeadlessDevice(int width, int height, bool enableErrorChecking);
         void destroyDevice();
         void createRenderer();
         void destroyRenderer(bool freePipelineResources=true);
@@ -65,6 +74,9 @@ class Device {
         void addMaterial(Material& material);
         void setMaterial(Material* material);
         Material* material() { return material_; }
+        void addComputeMaterial(ComputeMaterial& computeMaterial);
+        void invalidate(const Shader& shader);      // after a hot reload replaced it in place
+        void invalidate(const Texture& texture);
 
     public:
         void drawIndexed(size_t count, size_t offset=0);
@@ -75,7 +87,7 @@ class Device {
         void reinitRenderer();
 
     private:
-        void createInstance(Window& window);
+        void createInstance(std::vector<const char*> requiredInstanceExtensions);
         void destroyInstance();
 
         void createSurface(Window& window);
@@ -96,6 +108,10 @@ class Device {
         void createImageViews();
         void destroyImageViews();
 
+        void createRenderTargets();
+        void destroyRenderTargets();
+        void recordReadback(const Frame& frame);
+
         void createRenderPass();
         void destroyRenderPass();
 
@@ -108,6 +124,8 @@ class Device {
         void createCommandPool();
         void destroyCommandPool();
 
+        void createTextureTable();
+
         void createFrames();
         void destroyFrames();
 
@@ -121,10 +139,29 @@ class Device {
         bool begin(Window& window);
         bool end();
         bool isVisible() const { return visible_; }
+        bool isHeadless() const { return headless_; }
+
+    public: // headless rendering
+        void setReadback(bool enable) { readbackEnabled_ = enable; }
+        bool readback(std::vector<uint8_t>& pixels);
 
     public:
         VkCommandBuffer beginCommand();
         void endCommand(VkCommandBuffer commandBuffer);
+        void flushTransfers(bool wait=true);
+        TransferBatch& transfers() { return transfers_; }
+        MemoryAllocator& allocator() { return allocator_; }
+        GpuProfiler& profiler() { return profiler_; }
+        void setGpuProfiling(bool enable) { gpuProfiling_ = enable; }
+        void setParallelRecording(bool enable) { parallelRecording_ = enable; }  // before createRenderer()
+        void setPipelineCacheFile(const std::string& filename) { pipelineCacheFile_ = filename; }
+        VkPipelineCache pipelineCache() const { return pipelineCache_.ptr(); }
+        PipelineRegistry& pipelines() { return pipelines_; }
+        ThreadPool& workers() { return workers_; }
+        RenderQueue& renderQueue() { return renderQueue_; }
+        TextureTable& textureTable() { return textureTable_; }
+        SamplerCache& samplers() { return samplers_; }
+        bool isBindlessSupported() const { return bindlessSupported_; }
 
     public: // access methods
         VkInstance instance() const { return instance_.ptr(); }
@@ -135,10 +172,17 @@ class Device {
         VkPhysicalDevice physicalDevice() const { return physicalDevice_.ptr(); }
         VkQueue graphicsQueue() const { return graphicsQueue_.ptr(); }
         VkRenderPass renderPass() const { return renderPass_.ptr(); }
+        uint32_t graphicsFamilyIndex() const { return (uint32_t) physicalDeviceInfo_.graphicsFamilyIndex; }
         const Metrics& metrics() const { return metrics_; }
 
     private: // common
         bool enableErrorChecking_{false};
+        bool headless_{false};
+        bool readbackEnabled_{false};
+        bool gpuProfiling_{false};
+        bool parallelRecording_{false};
+        bool bindlessSupported_{false};
+        std::string pipelineCacheFile_;
 
     private: // Vulkan objects
         Reference<VkInstance> instance_;
@@ -146,7 +190,14 @@ class Device {
         Reference<VkDevice> device_;
         Reference<VkSurfaceKHR> surface_;
         Reference<VkRenderPass> renderPass_;
+        Reference<VkRenderPass> renderPassContinue_;   // loads the attachments, contents from secondary buffers
         Reference<VkCommandPool> commandPool_;
+        MemoryAllocator allocator_;
+        PipelineCache pipelineCache_;
+        PipelineRegistry pipelines_;
+        ThreadPool workers_;
+        TextureTable textureTable_;
+        SamplerCache samplers_;
 
     private:
         PhysicalDeviceInfo physicalDeviceInfo_{};
@@ -161,10 +212,21 @@ class Device {
         Window::WindowState windowState_{0,0,false};
         bool visible_{false};
         Metrics metrics_;
+        TransferBatch transfers_;
+        GpuProfiler profiler_;
+        RenderQueue renderQueue_;
+        uint32_t renderPassScope_{GpuProfiler::npos};
+
+    private: // headless
+        VkExtent2D headlessExtent_{};
+        std::vector<BufferObject> readbackBuffers_;
+        int readbackFrame_{-1};
 
     private:
         Material* material_{nullptr};
+        bool materialBound_{false};
         std::vector<Material*> materials_;
+        std::vector<ComputeMaterial*> computeMaterials_;
 
     private:
         std::vector<const char*> requiredDeviceExtensions_;
@@ -7,5 +7,9 @@
 #include "gamekit/api.h"
 #include "gamekit/sprite.h"
 #include "gamekit/sprite_batch.h"
+#include "gamekit/atlas.h"
+#include "gamekit/pack.h"
+#include "gamekit/watcher.h"
+#include "gamekit/particles.h"
 
 #include <glm/glm.hpp>
@@ -16,12 +16,14 @@ class Loader {
 
     public:
         void load();
+        void loadHeadless();
         void unload();
         void registerInstance(VkInstance instance);
         void unregisterInstance();
 
     private:
         bool loaded_{false};
+        bool headless_{false};
         VkInstance vulkanInstance_{nullptr};
 
     private:
@@ -6,19 +6,16 @@
 #include "gamekit/types.h"
 #include "gamekit/buffer.h"
 #include "gamekit/texture.h"
+#include "gamekit/vertex.h"
+#include "gamekit/pipeline.h"
 
 #include <vulkan>
 #include <string>
 #include <vector>
+#include <future>
 
 namespace gamekit {
 
-enum class BlendMode {
-    Normal = 0x1,
-    Additive = 0x2,
-    Multiply = 0x3
-};
-
 class Material {
 
     public:
@@ -27,16 +24,22 @@ class Material {
     private:
         void create();
         void update();
+        void poll();
+        void retire();
+        void releaseRetired(bool all=false);
+        PipelineDescription createPipelineDescription() const;
         void createGraphicsPipeline();
         void freeGraphicsPipeline();
         void createDescriptorSets();
         void freeDescriptorSets();
-        DescriptorSet createDescriptorSet();
-        void setDynamicStates();
+        DescriptorSet createDescriptorSet(size_t frameIndex);
 
     public:
-        void compile();
-        void bind();
+        void compile();     // blocking, for load time
+        bool prepare();     // once per frame, picks up finished compiles, false until a first pipeline is ready
+        bool bind();
+        void setDynamicStates();
+        void setDynamicStates(VkCommandBuffer commandBuffer) const;
         void destroy();
 
     public:
@@ -46,20 +49,38 @@ class Material {
         const PushConstantsBase* addPushConstants(PushConstantsBase& pushConstants);
 
     public:
+        // a used shader or texture was replaced in place, the device is idle
+        void invalidate(const Shader& shader);
+        void invalidate(const Texture& texture);
+
+    public:
+        // pushes are stored and recorded with the material's binds, deferred draws
+        // of the render queue see the last push of their material
         void updatePushConstants(const PushConstantsBase& pushConstants);
+        void recordPushConstants(VkCommandBuffer commandBuffer) const;
+        void flushPushConstants(VkCommandBuffer commandBuffer);    // pushes since the last bind, immediate draws
         const Texture* getTexture(uint32_t binding);
 
     public: // setters
         void setEnableBlending(bool enableBlending) { enableBlending_ = enableBlending; }
-        void setBlendMode(BlendMode blendMode) { blendMode_ = blendMode; }
-        void setBackfaceCulling(bool backfaceCulling) { backfaceCulling_ = backfaceCulling; };
-        void setFontFaceClockwise(bool fontfaceClockWise) { fontfaceClockWise_ = fontfaceClockWise; };
-        void setDepthTesting(bool depthTesting) { depthTesting_ = depthTesting; };
-        void setDepthWriting(bool depthWriting) { depthWriting_ = depthWriting; };
+        void setBlendMode(BlendMode blendMode) { blendMode_ = blendMode; modified_ = true; }
+        void setBackfaceCulling(bool backfaceCulling) { backfaceCulling_ = backfaceCulling; modified_ = true; };
+        void setFontFaceClockwise(bool fontfaceClockWise) { fontfaceClockWise_ = fontfaceClockWise; modified_ = true; };
+        void setDepthTesting(bool depthTesting) { depthTesting_ = depthTesting; modified_ = true; };
+        void setDepthWriting(bool depthWriting) { depthWriting_ = depthWriting; modified_ = true; };
+        void setVertexLayout(VertexLayout vertexLayout) { vertexLayout_ = vertexLayout; modified_ = true; };
+        void setBindless(bool bindless) { bindless_ = bindless; modified_ = true; };  // samples the device texture table
 
     public: // getters
         bool enableBlending() const { return enableBlending_; }
         BlendMode blendMode() const { return blendMode_; }
+        VertexLayout vertexLayout() const { return vertexLayout_; }
+        bool isBindless() const { return bindless_; }
+        bool isCompiling() const { return pendingPipeline_.valid(); }
+        bool isReady() const { return nullptr != pipeline_; }
+        uint32_t id() const { return id_; }
+        const PipelineRegistry::Pipeline* pipeline() const { return pipeline_; }
+        const DescriptorSet& descriptorSet(size_t frameIndex) const { return descriptorSets_[frameIndex]; }
         const DescriptorPool& descriptorPool() { return descriptorPool_; }
 
     private:
@@ -69,14 +90,27 @@ class Material {
         bool fontfaceClockWise_{false};
         bool depthTesting_{false};
         bool depthWriting_{false};
+        VertexLayout vertexLayout_{VertexLayout::PerVertex};
+        bool bindless_{false};
 
     private:
+        uint32_t id_{0};
         bool modified_{false};
         DescriptorPool descriptorPool_;
-        Reference<VkDescriptorSetLayout> descriptorSetLayout_;
-        Reference<VkPipelineLayout> pipelineLayout_;
-        Reference<VkPipeline> graphicsPipeline_;
+        const PipelineRegistry::Pipeline* pipeline_{nullptr};   // shared, owned by the device registry
         std::vector<DescriptorSet> descriptorSets_;
+        std::future<const PipelineRegistry::Pipeline*> pendingPipeline_;
+
+    private:
+        // replaced variant, kept alive until frames in flight have retired it
+        struct RetiredPipeline {
+            const PipelineRegistry::Pipeline* pipeline{nullptr};
+            DescriptorPool descriptorPool;
+            std::vector<DescriptorSet> descriptorSets;
+            size_t framesLeft{0};
+        };
+
+        std::vector<RetiredPipeline> retired_;
 
     private:
         struct TextureInfo {
@@ -88,10 +122,12 @@ class Material {
         std::vector<Buffer*> buffers_;
         size_t numVertexBuffers_{0};
         size_t numUniformBuffers_{0};
+        size_t numStorageBuffers_{0};
         std::vector<TextureInfo> textures_;
         std::vector<const Shader*> shaders_;
-        std::vector<VkPipelineShaderStageCreateInfo> shaderStages_;
         std::vector<VkPushConstantRange> pushConstantRanges_;
+        std::vector<uint8_t> pushConstantData_;     // last pushed bytes, replayed into each command buffer
+        bool pushConstantsPending_{false};
 
 };
 
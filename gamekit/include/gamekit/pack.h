@@ -0,0 +1,105 @@
+/*
+ * Pack
+ */
+#pragma once
+
+#include "gamekit/primitives.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Mapped File
+///////////////////////////////////////////////////////////////////////////////
+
+// read only file mapping, pages are loaded on first access
+class MappedFile {
+
+    public:
+        MappedFile() {}
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile() { close(); }
+
+    public:
+        static MappedFile open(const std::string& filename);
+        void close();
+
+    public:
+        [[nodiscard]] const uint8_t* data() const { return data_; }
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] bool isOpen() const { return nullptr != data_; }
+
+    private:
+        const uint8_t* data_{nullptr};
+        size_t size_{0};
+        void* file_{nullptr};       // windows file and mapping handles
+        void* mapping_{nullptr};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Resource Pack
+///////////////////////////////////////////////////////////////////////////////
+
+// indexed binary pack written by gamekitc, see tools/gkpack.py
+class ResourcePack {
+
+    public:
+        static const uint32_t VERSION = 1;
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t slotCount;         // power of two, at least twice the entries, linear probing
+            uint32_t reserved;
+            uint64_t entriesOffset;
+            uint64_t slotsOffset;
+            uint64_t namesOffset;
+        };
+
+        struct Entry {
+            uint64_t hash;              // makeResourceId of the name
+            uint64_t offset;
+            uint64_t size;
+            uint32_t nameOffset;        // into the name table, zero terminated
+            uint32_t nameSize;
+            uint32_t type;
+            uint32_t reserved;
+        };
+
+    public:
+        ResourcePack() {}
+        ResourcePack(const ResourcePack&) = delete;
+        ResourcePack& operator=(const ResourcePack&) = delete;
+        ResourcePack(ResourcePack&&) = default;
+        ResourcePack& operator=(ResourcePack&&) = default;
+
+    public:
+        // relative filenames are looked up next to the executable, then in the search paths
+        static ResourcePack open(const std::string& filename, const std::vector<std::string>& searchPaths={});
+        void destroy();
+
+    public:
+        [[nodiscard]] const ResourceDescriptor* find(std::string_view name) const;   // nullptr if not found
+        [[nodiscard]] const std::vector<ResourceDescriptor>& descriptors() const { return descriptors_; }
+        [[nodiscard]] size_t size() const { return descriptors_.size(); }
+
+    private:
+        void create(MappedFile&& file);
+
+    private:
+        MappedFile file_;
+        const Entry* entries_{nullptr};
+        const uint32_t* slots_{nullptr};
+        uint32_t slotCount_{0};
+        std::vector<ResourceDescriptor> descriptors_;   // data points into the mapping
+};
+
+} // namespace
@@ -0,0 +1,87 @@
+/*
+ * Particles
+ */
+#pragma once
+
+#include "gamekit/sprite_batch.h"
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Particle System
+///////////////////////////////////////////////////////////////////////////////
+
+class ParticleSystem {
+
+    public:
+        static const size_t CHUNK_SIZE = 16384;
+
+        struct Params {
+            glm::vec2 size{24.0f, 24.0f};
+            float speed{500.0f};
+            float steering{5.0f};               // acceleration towards the target
+            float gravity{5.0f};
+            float bounce{2.0f};                 // vertical speed factor when hitting the floor
+            float respawnDistance{100.0f};      // pick a new target when closer than this
+            float minTimeToLive{2.0f};
+            float maxTimeToLive{5.0f};
+        };
+
+    private:
+        struct Chunk {
+            size_t begin{0};
+            size_t end{0};
+            uint32_t random{0};                 // xorshift state, one per chunk
+        };
+
+    public:
+        static ParticleSystem make(size_t capacity, const glm::vec4& bounds, uint32_t seed=0x9e3779b9);
+        void create(size_t capacity, const glm::vec4& bounds, uint32_t seed=0x9e3779b9);
+
+    public:
+        void setParams(const Params& params) { params_ = params; }
+        void setParallel(bool parallel) { parallel_ = parallel; }
+
+    public:
+        void update(float deltaTime, const glm::vec4& bounds);
+        void update(float deltaTime, const glm::vec4& bounds, QuadInstanceBatch& batch);
+        // interpolation blends from the positions before the last update, 1 writes the current ones
+        void write(QuadInstanceBatch& batch, float interpolation=1.0f) const;
+        void write(QuadBatch& batch, float interpolation=1.0f) const;
+
+    public:
+        [[nodiscard]] size_t count() const { return count_; }
+        [[nodiscard]] const Params& params() const { return params_; }
+        [[nodiscard]] bool isParallel() const { return parallel_; }
+
+    private:
+        void updateChunk(Chunk& chunk, float deltaTime, const glm::vec4& bounds, QuadInstance* output, size_t outputCount);
+        void writeChunk(const Chunk& chunk, QuadInstance* output, size_t outputCount, float interpolation=1.0f) const;
+        void respawn(size_t index, uint32_t& random, const glm::vec4& bounds, bool initial);
+
+    private:
+        size_t count_{0};
+        Params params_;
+        bool parallel_{true};
+        std::vector<Chunk> chunks_;
+
+        // structure of arrays, one entry per particle
+        std::vector<float> positionX_;
+        std::vector<float> positionY_;
+        std::vector<float> previousX_;          // before the last update, for interpolation
+        std::vector<float> previousY_;
+        std::vector<float> velocityX_;
+        std::vector<float> velocityY_;
+        std::vector<float> targetX_;
+        std::vector<float> targetY_;
+        std::vector<float> timeToLive_;
+        std::vector<uint32_t> color_;           // packed RGBA8, see QuadInstance
+        std::vector<uint32_t> texmask_;
+        std::vector<uint8_t> expired_;          // scratch, set by the motion kernel
+};
+
+} // namespace
@@ -0,0 +1,152 @@
+/*
+ * Pipeline
+ */
+#pragma once
+
+#include "gamekit/reference.h"
+#include "gamekit/types.h"
+#include "gamekit/vertex.h"
+
+#include <vulkan>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+namespace gamekit {
+
+enum class BlendMode {
+    Normal = 0x1,
+    Additive = 0x2,
+    Multiply = 0x3
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline Cache
+///////////////////////////////////////////////////////////////////////////////
+
+class PipelineCache {
+
+    private:
+        static const uint32_t MAGIC = 0x43504b47; // "GKPC"
+        static const uint32_t VERSION = 1;
+
+        // prepended to the driver blob, data of another device or driver is dropped
+        struct FileHeader {
+            uint32_t magic{MAGIC};
+            uint32_t version{VERSION};
+            uint32_t vendorID{0};
+            uint32_t deviceID{0};
+            uint32_t driverVersion{0};
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE]{};
+            uint64_t dataSize{0};
+        };
+
+    public:
+        void create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& filename);
+        void destroy();
+        bool save() const;
+
+    public:
+        [[nodiscard]] VkPipelineCache ptr() const { return handle_.ptr(); }
+        [[nodiscard]] const std::string& filename() const { return filename_; }
+        [[nodiscard]] bool isLoaded() const { return loaded_; }
+        operator VkPipelineCache() const { return handle_.ptr(); }
+
+    private:
+        bool load(std::vector<uint8_t>& data) const;
+
+    private:
+        Reference<VkPipelineCache> handle_;
+        std::string filename_;
+        FileHeader header_{};
+        bool loaded_{false};
+};
+
+template <> void Reference<VkPipelineCache>::destroy();
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline Description
+///////////////////////////////////////////////////////////////////////////////
+
+struct PipelineDescription {
+
+    struct Stage {
+        VkShaderStageFlagBits stage{VK_SHADER_STAGE_VERTEX_BIT};
+        VkShaderModule module{nullptr};
+    };
+
+    std::vector<Stage> stages;
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    VkDescriptorSetLayout textureTableLayout{nullptr};     // bindless texture array at set 1 when set
+    VertexLayout vertexLayout{VertexLayout::PerVertex};
+    BlendMode blendMode{BlendMode::Normal};
+    bool backfaceCulling{true};
+    bool frontFaceClockwise{false};
+    bool depthTesting{false};
+    bool depthWriting{false};
+    VkRenderPass renderPass{nullptr};
+
+    [[nodiscard]] bool isCompute() const;
+    [[nodiscard]] size_t hash() const;
+    [[nodiscard]] size_t layoutHash() const;
+    [[nodiscard]] bool sameLayout(const PipelineDescription& other) const;
+    bool operator==(const PipelineDescription& other) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline Registry
+///////////////////////////////////////////////////////////////////////////////
+
+class PipelineRegistry {
+
+    public:
+        struct Layout {
+            PipelineDescription description;    // bindings, push constants and texture table only
+            Reference<VkDescriptorSetLayout> descriptorSetLayout;
+            Reference<VkPipelineLayout> pipelineLayout;
+            size_t refCount{0};
+        };
+
+        struct Pipeline {
+            PipelineDescription description;
+            Layout* layout{nullptr};
+            Reference<VkPipeline> handle;
+            size_t refCount{0};
+            uint32_t id{0};     // small and unique while alive, used in sort keys
+
+            [[nodiscard]] VkPipeline ptr() const { return handle.ptr(); }
+            [[nodiscard]] VkPipelineLayout pipelineLayout() const { return layout->pipelineLayout.ptr(); }
+            [[nodiscard]] VkDescriptorSetLayout descriptorSetLayout() const { return layout->descriptorSetLayout.ptr(); }
+            [[nodiscard]] bool isBindless() const { return nullptr != description.textureTableLayout; }
+        };
+
+    public:
+        // thread safe, pipelines may be compiled on worker threads
+        const Pipeline* acquire(const PipelineDescription& description);
+        void release(const Pipeline* pipeline);
+        void destroy();
+
+    public:
+        [[nodiscard]] size_t pipelineCount() const;
+        [[nodiscard]] size_t layoutCount() const;
+
+    private:
+        const Pipeline* find(size_t hash, const PipelineDescription& description);
+        Layout* acquireLayout(const PipelineDescription& description);
+        void releaseLayout(Layout* layout);
+        void createGraphicsPipeline(Pipeline& pipeline);
+        void createComputePipeline(Pipeline& pipeline);
+
+    private:
+        // keyed by hash, equal hashes are told apart by comparing descriptions
+        std::unordered_multimap<size_t, std::unique_ptr<Pipeline>> pipelines_;
+        std::unordered_multimap<size_t, std::unique_ptr<Layout>> layouts_;
+        uint32_t nextId_{1};
+        mutable std::mutex mutex_;
+};
+
+} // namespace
@@ -5,19 +5,35 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace gamekit {
 
 typedef int64_t microsecond_t;
 typedef int64_t nanosecond_t;
 
+// 64 bit FNV-1a of the resource name, gamekitc emits them as constants
+typedef uint64_t ResourceId;
+
+constexpr ResourceId makeResourceId(std::string_view name) {
+    uint64_t value = 0xcbf29ce484222325ull;
+    for (auto c : name) {
+        value ^= static_cast<uint8_t>(c);
+        value *= 0x100000001b3ull;
+    }
+    return value;
+}
+
 enum class ResourceType {
     Unknown = 0x0,
     Data = 0x1,
     Text = 0x2,
     Bitmap = 0x3,
     VertexShader = 0x4,
-    FragmentShader = 0x5
+    FragmentShader = 0x5,
+    ComputeShader = 0x6,
+    Atlas = 0x7,
+    CompressedBitmap = 0x8     // block compressed mip chain written by gamekitc
 };
 
 struct ResourceDescriptor {
@@ -0,0 +1,98 @@
+/*
+ * Profiler
+ */
+#pragma once
+
+#include <vulkan>
+
+#include "gamekit/types.h"
+
+#include <vector>
+#include <string>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU Profiler
+///////////////////////////////////////////////////////////////////////////////
+
+class GpuProfiler {
+
+    public:
+        static const uint32_t MAX_QUERIES = 512;
+        static const uint32_t npos = (uint32_t) -1;
+
+    public:
+        struct Result {
+            const char* name{nullptr};
+            double time{0.0};       // accumulated GPU time in microseconds
+            uint32_t count{0};      // number of scopes merged into this entry
+        };
+
+    private:
+        struct Scope {
+            const char* name{nullptr};
+            uint32_t query{0};
+        };
+
+        struct FrameQueries {
+            QueryPool queryPool;
+            std::vector<Scope> scopes;
+            uint32_t queryCount{0};
+        };
+
+    public:
+        GpuProfiler() {}
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+        ~GpuProfiler() { destroy(); }
+
+    public:
+        void create(size_t frameCount, uint32_t timestampValidBits);
+        void destroy();
+
+    public:
+        void beginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+        [[nodiscard]] uint32_t beginScope(const char* name);
+        void endScope(uint32_t scope);
+
+    public:
+        [[nodiscard]] bool isEnabled() const { return !frames_.empty(); }
+        [[nodiscard]] const std::vector<Result>& results() const { return results_; }
+        [[nodiscard]] double frameTime() const { return frameTime_; }
+        [[nodiscard]] uint64_t resolvedFrames() const { return resolvedFrames_; }
+
+    private:
+        void resolve(FrameQueries& frame);
+
+    private:
+        std::vector<FrameQueries> frames_;
+        FrameQueries* current_{nullptr};
+        VkCommandBuffer commandBuffer_{nullptr};
+        double timestampPeriod_{1.0};
+        uint64_t timestampMask_{~0ull};
+        std::vector<Result> results_;
+        double frameTime_{0.0};
+        uint64_t resolvedFrames_{0};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU Scope
+///////////////////////////////////////////////////////////////////////////////
+
+class GpuScope {
+    public:
+        GpuScope(GpuProfiler& profiler, const char* name) :
+            profiler_{profiler},
+            scope_{profiler.beginScope(name)} {}
+        ~GpuScope() { profiler_.endScope(scope_); }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuProfiler& profiler_;
+        uint32_t scope_;
+};
+
+} // namespace
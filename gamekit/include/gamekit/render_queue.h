@@ -0,0 +1,90 @@
+/*
+ * Render Queue
+ */
+#pragma once
+
+#include "gamekit/reference.h"
+#include "gamekit/types.h"
+
+#include <vulkan>
+#include <vector>
+#include <cstdint>
+
+namespace gamekit {
+
+class Material;
+
+///////////////////////////////////////////////////////////////////////////////
+// Draw Command
+///////////////////////////////////////////////////////////////////////////////
+
+struct DrawCommand {
+    Material* material{nullptr};
+    VkBuffer vertexBuffer{nullptr};
+    VkBuffer indexBuffer{nullptr};      // indexed draw when set, 16 bit indices
+    uint32_t count{0};                  // indices or vertices per instance
+    uint32_t first{0};
+    uint32_t instances{1};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Render Queue
+///////////////////////////////////////////////////////////////////////////////
+
+class RenderQueue {
+
+    public:
+        static const uint32_t MAX_LAYERS = 16;
+        static const size_t MIN_DRAWS_PER_THREAD = 256;   // below that, recording is cheaper than handing off
+
+        // sort key, most significant first:
+        // layer (4) | pipeline (16) | material (16) | vertex buffer (16) | depth (12)
+        static uint64_t makeKey(uint32_t layer, uint32_t pipelineId, uint32_t materialId, VkBuffer vertexBuffer, float depth);
+
+        struct Statistics {
+            size_t draws{0};
+            size_t pipelineBinds{0};
+            size_t descriptorSetBinds{0};
+            size_t vertexBufferBinds{0};
+            size_t indexBufferBinds{0};
+        };
+
+    public:
+        void submit(const DrawCommand& command, uint32_t layer=0, float depth=0.0f);
+        void flush();   // sorts and records into the current frame, then clears
+        void flushParallel(VkRenderPass renderPass, VkFramebuffer framebuffer, const VkExtent2D& extent);
+        void clear();
+        void destroy();
+
+    public:
+        [[nodiscard]] size_t size() const { return commands_.size(); }
+        [[nodiscard]] bool empty() const { return commands_.empty(); }
+        [[nodiscard]] const Statistics& statistics() const { return statistics_; }  // of the last flush
+
+    private:
+        void sort();
+        void record(VkCommandBuffer commandBuffer, size_t first, size_t last, size_t frameIndex, Statistics& statistics) const;
+        VkCommandBuffer beginSecondary(size_t frameIndex, size_t chunk, const VkCommandBufferInheritanceInfo& inheritanceInfo);
+
+    private:
+        struct SortItem {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        std::vector<DrawCommand> commands_;
+        std::vector<SortItem> items_;
+        std::vector<SortItem> scratch_;
+        Statistics statistics_;
+
+    private:
+        // one pool per frame slot and recording thread, reset when the slot comes around
+        struct Recorder {
+            Reference<VkCommandPool> commandPool;
+            Reference<VkCommandBuffer> commandBuffer;   // owned by the pool
+        };
+
+        std::vector<std::vector<Recorder>> recorders_;
+};
+
+} // namespace
@@ -6,14 +6,155 @@
 #include "gamekit/primitives.h"
 #include "gamekit/types.h"
 #include "gamekit/texture.h"
+#include "gamekit/atlas.h"
+#include "gamekit/watcher.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
+#include <initializer_list>
 #include <unordered_map>
+#include <memory>
+#include <future>
+#include <atomic>
 
 namespace gamekit {
 
+///////////////////////////////////////////////////////////////////////////////
+// Resource Load
+///////////////////////////////////////////////////////////////////////////////
+
+enum class LoadState {
+    Pending = 0x0,
+    Ready = 0x1,
+    Failed = 0x2
+};
+
+class ResourceLoad {
+
+    public:
+        [[nodiscard]] const std::string& id() const { return id_; }
+        [[nodiscard]] ResourceId resourceId() const { return resourceId_; }
+        [[nodiscard]] LoadState state() const { return state_.load(std::memory_order_acquire); }
+        [[nodiscard]] bool isReady() const { return LoadState::Ready == state(); }
+        [[nodiscard]] bool isFailed() const { return LoadState::Failed == state(); }
+        [[nodiscard]] bool isDone() const { return LoadState::Pending != state(); }
+        [[nodiscard]] const std::string& error() const { return error_; }   // set when failed
+
+    private:
+        friend class Resources;
+
+        std::string id_;
+        ResourceId resourceId_{0};
+        ResourceType type_{ResourceType::Unknown};
+        std::future<Image::Source> decoded_;    // images only
+        std::atomic<LoadState> state_{LoadState::Pending};
+        std::string error_;
+};
+
+using LoadHandle = std::shared_ptr<const ResourceLoad>;
+
+///////////////////////////////////////////////////////////////////////////////
+// Resource Table
+///////////////////////////////////////////////////////////////////////////////
+
+// open addressing id to index table, values live in a deque and keep
+// their address when the table grows
+template <typename T> class ResourceTable {
+
+    public:
+        [[nodiscard]] T* find(ResourceId id);
+        [[nodiscard]] const T* find(ResourceId id) const;
+        [[nodiscard]] bool contains(ResourceId id) const { return nullptr != find(id); }
+        [[nodiscard]] size_t size() const { return values_.size(); }
+        T& insert(ResourceId id, T&& value);   // id must not be present
+        void clear();
+
+    public:
+        auto begin() { return values_.begin(); }
+        auto end() { return values_.end(); }
+
+    private:
+        void grow();
+
+    private:
+        struct Slot {
+            ResourceId id{0};
+            uint32_t index{0};  // value index + 1, 0 is empty
+        };
+
+        std::vector<Slot> slots_;
+        std::deque<T> values_;
+};
+
+template <typename T> T* ResourceTable<T>::find(ResourceId id) {
+    return const_cast<T*>(static_cast<const ResourceTable<T>*>(this)->find(id));
+}
+
+template <typename T> const T* ResourceTable<T>::find(ResourceId id) const {
+
+    if (slots_.empty()) return nullptr;
+
+    auto mask = slots_.size() - 1;
+
+    for (auto slot = static_cast<size_t>(id) & mask; ; slot = (slot + 1) & mask) {
+        const auto& entry = slots_[slot];
+        if (0 == entry.index) return nullptr;
+        if (id == entry.id) return &values_[entry.index - 1];
+    }
+}
+
+template <typename T> T& ResourceTable<T>::insert(ResourceId id, T&& value) {
+
+    // at most half full, probing always ends at an empty slot
+    if ((values_.size() + 1) * 2 > slots_.size()) {
+        grow();
+    }
+
+    auto mask = slots_.size() - 1;
+    auto slot = static_cast<size_t>(id) & mask;
+    while (0 != slots_[slot].index) {
+        slot = (slot + 1) & mask;
+    }
+
+    auto& result = values_.emplace_back(std::move(value));
+    slots_[slot] = { id, static_cast<uint32_t>(values_.size()) };
+
+    return result;
+}
+
+template <typename T> void ResourceTable<T>::clear() {
+    slots_.clear();
+    values_.clear();
+}
+
+template <typename T> void ResourceTable<T>::grow() {
+
+    std::vector<Slot> slots(slots_.empty() ? 64 : slots_.size() * 2);
+    auto mask = slots.size() - 1;
+
+    for (const auto& entry : slots_) {
+        if (0 == entry.index) continue;
+        auto slot = static_cast<size_t>(entry.id) & mask;
+        while (0 != slots[slot].index) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = entry;
+    }
+
+    slots_ = std::move(slots);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Resources
+///////////////////////////////////////////////////////////////////////////////
+
 class Resources {
+
+    public:
+        static const size_t DEFAULT_UPLOAD_BUDGET = 16 * 1024 * 1024;  // bytes per update
+
     public:
         Resources() {}
         Resources(const Resources&) = delete;
@@ -27,16 +168,52 @@ class Resources {
         void destroy();
 
     public:
-        const ResourceDescriptor& get(const std::string& id) const;
-        const Shader& getShader(const std::string& id);
-        const Image& getImage(const std::string& id);
-        const Texture& getTexture(const std::string& id);
+        const ResourceDescriptor& get(ResourceId id) const;
+        const Shader& getShader(ResourceId id);
+        const Image& getImage(ResourceId id);
+        const Texture& getTexture(ResourceId id);
+        const Atlas& getAtlas(ResourceId id);
+
+    public:
+        // name lookups hash on every call, prefer the generated ids in hot code
+        const ResourceDescriptor& get(std::string_view name) const { return get(makeResourceId(name)); }
+        const Shader& getShader(std::string_view name) { return getShader(makeResourceId(name)); }
+        const Image& getImage(std::string_view name) { return getImage(makeResourceId(name)); }
+        const Texture& getTexture(std::string_view name) { return getTexture(makeResourceId(name)); }
+        const Atlas& getAtlas(std::string_view name) { return getAtlas(makeResourceId(name)); }
+
+    public:
+        // images are decoded on the device workers and uploaded by update()
+        // on the render thread, other resource types are created there directly
+        LoadHandle loadAsync(ResourceId id);
+        LoadHandle loadAsync(std::string_view name) { return loadAsync(makeResourceId(name)); }
+        void preload(const std::vector<ResourceId>& ids);   // blocks until all are uploaded
+        void preload(std::initializer_list<std::string_view> names);
+        void update(size_t uploadBudget=DEFAULT_UPLOAD_BUDGET);
+        [[nodiscard]] size_t pendingLoads() const { return loads_.size(); }
+
+    public:
+        // development builds: files changed below the resource source folder are picked
+        // up by update(), shaders are compiled with glslc, images decoded from the source
+        // and both replaced in place so dependent materials rebuild on the next frame
+        void watch(const std::string& sourceFolder);
+        bool reload(std::string_view name, const std::string& filename);   // false if not a reloadable resource
+        [[nodiscard]] bool isWatching() const { return watcher_.isWatching(); }
+
+    private:
+        [[nodiscard]] bool isLoaded(ResourceId id, ResourceType type) const;
+        size_t finishLoad(ResourceLoad& load);
+        void reloadChanged();
 
     private:
-        std::unordered_map<std::string, ResourceDescriptor> descriptors_;
-        std::unordered_map<std::string, Shader> shaders_;
-        std::unordered_map<std::string, Image> images_;
-        std::unordered_map<std::string, Texture> textures_;
+        ResourceTable<ResourceDescriptor> descriptors_;
+        ResourceTable<Shader> shaders_;
+        ResourceTable<Image> images_;
+        ResourceTable<Texture> textures_;
+        ResourceTable<Atlas> atlases_;
+        std::unordered_map<ResourceId, std::shared_ptr<ResourceLoad>> loads_;
+        FileWatcher watcher_;
+        ResourceTable<std::vector<uint8_t>> reloaded_;  // descriptor data of reloaded resources
 };
 
 } // namespace
@@ -8,6 +8,8 @@
 #include <gamekit/device.h>
 #include <gamekit/vertex.h>
 #include <gamekit/buffer.h>
+#include <gamekit/render_queue.h>
+#include <gamekit/atlas.h>
 
 #include <array>
 #include <glm/glm.hpp>
@@ -20,6 +22,7 @@ class Quad {
         static Quad make();
         virtual void create();
         virtual void draw();
+        void submit(RenderQueue& queue, Material& material, uint32_t layer=0, float depth=0.0f);
 
     public:
         const glm::vec4& coords() const { return coords_; }
@@ -77,6 +80,7 @@ class Sprite {
 
     public:
         void setFrame(int frame) { frame_ = frame; }
+        void setFrame(const Atlas& atlas, const std::string& name);   // resolves the name once
         int frame() const { return frame_; }
 
     private:
@@ -9,8 +9,11 @@
 #include <gamekit/vertex.h>
 #include <gamekit/buffer.h>
 #include "gamekit/sprite.h"
+#include "gamekit/render_queue.h"
+#include "gamekit/atlas.h"
 
 #include <vector>
+#include <atomic>
 #include <glm/glm.hpp>
 
 namespace gamekit {
@@ -20,13 +23,21 @@ class VertexQueue {
         static const size_t npos = (size_t) -1; // std::numeric_limits<std::size_t>::max();
 
     public:
-        static VertexQueue make(size_t capacity);
-        void create(size_t capacity);
+        static VertexQueue make(size_t capacity, bool streaming=false);
+        void create(size_t capacity, bool streaming=false);
+
+    public:
+        VertexQueue() {}
+        VertexQueue(VertexQueue&& ref);
+        VertexQueue& operator=(VertexQueue&& ref);
+        VertexQueue(const VertexQueue&) = delete;
+        VertexQueue& operator=(const VertexQueue&) = delete;
 
     public:
         void begin();
         void end();
         void draw();
+        void submit(RenderQueue& queue, Material& material, uint32_t layer=0, float depth=0.0f);
         void clear();
         size_t reserve(size_t numIndices=1);
 
@@ -43,7 +54,15 @@ class VertexQueue {
 
     public:
         [[nodiscard]] size_t capacity() const { return capacity_; }
-        [[nodiscard]] size_t count() const { return count_; }
+        [[nodiscard]] size_t count() const { return used() - reserved_; }
+        [[nodiscard]] bool isStreaming() const { return vertexBuffer_.isStreaming(); }
+
+    protected:
+        [[nodiscard]] size_t used() const {
+            // the cursor may run past capacity on concurrent overflow
+            auto num = count_.load(std::memory_order_relaxed) + reserved_;
+            return num < capacity_ ? num : capacity_;
+        }
 
     private:
         inline void checkIndex(size_t& index);
@@ -61,10 +80,11 @@ class VertexQueue {
     protected:
         size_t capacity_{0};
         size_t reserved_{0};
-        size_t count_{0};
+        std::atomic<size_t> count_{0};  // append cursor, shared by concurrent pushes
         bool modified_{false};
 
     private:
+        Vertex* vertexData_{nullptr};   // staging vector or mapped frame memory (streaming)
         std::vector<Vertex> vertices_;
         std::vector<uint16_t> indices_;
         VertexBuffer vertexBuffer_;
@@ -73,8 +93,8 @@ class VertexQueue {
 
 class QuadBatch : public VertexQueue {
     public:
-        static QuadBatch make(size_t capacity);
-        void create(size_t capacity);
+        static QuadBatch make(size_t capacity, bool streaming=false);
+        void create(size_t capacity, bool streaming=false);
 
     public:
         void push(const glm::vec4& rect);
@@ -88,6 +108,12 @@ class QuadBatch : public VertexQueue {
                   float tx, float ty, float tw, float th,
                   uint32_t texmask, uint32_t flags);
 
+    public: // thread-safe, returns false when the batch is full
+        bool concurrentPush(float x, float y, float w, float h,
+                            float r, float g, float b, float a,
+                            float tx, float ty, float tw, float th,
+                            uint32_t texmask, uint32_t flags);
+
     public:
         void store(size_t index, const glm::vec4& rect);
         void store(size_t index,
@@ -109,16 +135,119 @@ class QuadBatch : public VertexQueue {
 class SpriteBatch : public VertexQueue {
 
     public:
-        static SpriteBatch make(size_t capacity);
-        void create(size_t capacity);
+        static SpriteBatch make(size_t capacity, bool streaming=false);
+        void create(size_t capacity, bool streaming=false);
 
     public:
         void push(const Sprite& sprite);
         void store(size_t index, const Sprite& sprite);
 
+    public:
+        // sprite frames select atlas rects, page n is sampled via texture mask bit n
+        void setAtlas(const Atlas* atlas) { atlas_ = atlas; }
+        [[nodiscard]] const Atlas* atlas() const { return atlas_; }
+
     private:
         void set(const Sprite& sprite, size_t index=npos);
 
+    private:
+        const Atlas* atlas_{nullptr};
+
+};
+
+class QuadInstanceBatch {
+    protected:
+        static const size_t npos = (size_t) -1;
+
+    public:
+        static QuadInstanceBatch make(size_t capacity, bool streaming=false);
+        void create(size_t capacity, bool streaming=false);
+
+    public:
+        QuadInstanceBatch() {}
+        QuadInstanceBatch(QuadInstanceBatch&& ref);
+        QuadInstanceBatch& operator=(QuadInstanceBatch&& ref);
+        QuadInstanceBatch(const QuadInstanceBatch&) = delete;
+        QuadInstanceBatch& operator=(const QuadInstanceBatch&) = delete;
+
+    public:
+        void begin();
+        void end();
+        void draw();
+        void submit(RenderQueue& queue, Material& material, uint32_t layer=0, float depth=0.0f);
+        void clear();
+        size_t reserve(size_t numInstances=1);
+
+    public:
+        void update();
+
+    public:
+        void push(const glm::vec4& rect);
+        void push(const glm::vec4& rect,
+                  const glm::vec4& color,
+                  const glm::vec4& texcoords,
+                  uint32_t texmask,
+                  uint32_t flags);
+        void push(float x, float y, float w, float h,
+                  float r, float g, float b, float a,
+                  float tx, float ty, float tw, float th,
+                  uint32_t texmask, uint32_t flags);
+
+    public: // thread-safe, returns false when the batch is full
+        bool concurrentPush(const glm::vec4& rect,
+                            const glm::vec4& color,
+                            const glm::vec4& texcoords,
+                            uint32_t texmask,
+                            uint32_t flags);
+        bool concurrentPush(float x, float y, float w, float h,
+                            float r, float g, float b, float a,
+                            float tx, float ty, float tw, float th,
+                            uint32_t texmask, uint32_t flags);
+        // contiguous range, numAppended records fit before the capacity, nullptr when full
+        QuadInstance* concurrentAppend(size_t numInstances, size_t& numAppended);
+
+    public:
+        void store(size_t index, const glm::vec4& rect);
+        void store(size_t index,
+                   const glm::vec4& rect,
+                   const glm::vec4& color,
+                   const glm::vec4& texcoords,
+                   uint32_t texmask,
+                   uint32_t flags);
+        void store(size_t index,
+                   float x, float y, float w, float h,
+                   float r, float g, float b, float a,
+                   float tx, float ty, float tw, float th,
+                   uint32_t texmask,
+                   uint32_t flags);
+
+    public:
+        [[nodiscard]] size_t capacity() const { return capacity_; }
+        [[nodiscard]] size_t count() const { return used() - reserved_; }
+        [[nodiscard]] bool isStreaming() const { return instanceBuffer_.isStreaming(); }
+        [[nodiscard]] QuadInstance* instances() { return instanceData_; }
+
+    private:
+        inline QuadInstance* next();
+        inline QuadInstance* nextConcurrent();
+        inline QuadInstance* at(size_t index);
+
+    protected:
+        [[nodiscard]] size_t used() const {
+            auto num = count_.load(std::memory_order_relaxed) + reserved_;
+            return num < capacity_ ? num : capacity_;
+        }
+
+    protected:
+        size_t capacity_{0};
+        size_t reserved_{0};
+        std::atomic<size_t> count_{0};  // append cursor, shared by concurrent pushes
+        bool modified_{false};
+
+    private:
+        QuadInstance* instanceData_{nullptr};   // staging vector or mapped frame memory (streaming)
+        std::vector<QuadInstance> instances_;
+        VertexBuffer instanceBuffer_;
 };
 
 } // namespace
@@ -13,9 +13,9 @@ namespace gamekit {
 class Texture {
 
     public:
-        static Texture make(const ResourceDescriptor& resourceDescriptor);
-        static Texture make(const std::string& filename);
-        static Texture make(const Image& image);
+        static Texture make(const ResourceDescriptor& resourceDescriptor, const SamplerDescription& samplerDescription={});
+        static Texture make(const std::string& filename, const SamplerDescription& samplerDescription={});
+        static Texture make(const Image& image, const SamplerDescription& samplerDescription={});
 
     public:
         Texture();
@@ -29,15 +29,15 @@ class Texture {
         void free();
 
     protected:
-        void create(const ResourceDescriptor& filename);
-        void create(const std::string& filename);
-        void create(const Image& image);
+        void create(const ResourceDescriptor& filename, const SamplerDescription& samplerDescription);
+        void create(const std::string& filename, const SamplerDescription& samplerDescription);
+        void create(const Image& image, const SamplerDescription& samplerDescription);
         void destroy();
 
     public:
         [[nodiscard]] const Image& image() const { return image_; }
         [[nodiscard]] const ImageView& imageView() const { return imageView_; }
-        [[nodiscard]] const Sampler& sampler() const { return sampler_; }
+        [[nodiscard]] const Sampler& sampler() const { return *sampler_; }
         [[nodiscard]] int width() const { return width_; }
         [[nodiscard]] int height() const { return height_; }
 
@@ -45,7 +45,7 @@ class Texture {
         std::string filename_;
         Image image_;
         ImageView imageView_;
-        Sampler sampler_;
+        const Sampler* sampler_{nullptr};    // shared, owned by the device sampler cache
         int width_{0};
         int height_{0};
 
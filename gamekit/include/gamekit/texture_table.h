@@ -0,0 +1,74 @@
+/*
+ * Texture Table
+ */
+#pragma once
+
+#include "gamekit/reference.h"
+#include "gamekit/types.h"
+#include "gamekit/texture.h"
+
+#include <vulkan>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Texture Table
+///////////////////////////////////////////////////////////////////////////////
+
+// device wide bindless texture array (descriptor indexing). textures are
+// registered once, shaders select them by the index passed in the vertex
+// or instance texture field instead of a mask bit.
+class TextureTable {
+
+    public:
+        static const uint32_t SET = 1;                  // descriptor set of the array in bindless pipeline layouts
+        static const uint32_t BINDING = 0;
+        static const uint32_t MAX_TEXTURES = 4096;
+        static const uint32_t NO_TEXTURE = 0;           // reserved slot, never written, means untextured
+
+    public:
+        TextureTable() = default;
+        TextureTable(const TextureTable&) = delete;
+        TextureTable& operator=(const TextureTable&) = delete;
+
+    public:
+        void create(uint32_t capacity);
+        void destroy();
+        void update();      // once per frame, recycles slots released frames in flight ago
+
+    public:
+        uint32_t add(const Texture& texture);           // returns the index, same index for the same texture
+        void remove(const Texture& texture);
+        void refresh(const Texture& texture);           // rewrites the slot after the texture was replaced in place
+        uint32_t indexOf(const Texture& texture) const; // NO_TEXTURE if not registered
+
+    public:
+        [[nodiscard]] bool isValid() const { return layout_.notNull(); }
+        [[nodiscard]] uint32_t capacity() const { return capacity_; }
+        [[nodiscard]] size_t count() const { return indices_.size(); }
+        [[nodiscard]] VkDescriptorSetLayout layout() const { return layout_.ptr(); }
+        [[nodiscard]] const DescriptorSet& descriptorSet() const { return descriptorSet_; }
+
+    private:
+        void write(uint32_t index, const Texture& texture);
+
+    private:
+        struct ReleasedSlot {
+            uint32_t index{0};
+            size_t framesLeft{0};
+        };
+
+        Reference<VkDescriptorSetLayout> layout_;
+        DescriptorPool descriptorPool_;
+        DescriptorSet descriptorSet_;
+        uint32_t capacity_{0};
+        uint32_t next_{NO_TEXTURE + 1};
+        std::vector<uint32_t> free_;
+        std::vector<ReleasedSlot> released_;
+        std::unordered_map<const Texture*, uint32_t> indices_;
+};
+
+} // namespace
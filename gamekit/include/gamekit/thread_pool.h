@@ -0,0 +1,69 @@
+/*
+ * Thread Pool
+ */
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Thread Pool
+///////////////////////////////////////////////////////////////////////////////
+
+class ThreadPool {
+
+    public:
+        ThreadPool() = default;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+    public:
+        void create(size_t numThreads=0);   // 0: one less than the hardware threads
+        void destroy();                     // finishes queued tasks, then joins
+
+    public:
+        template <typename F> auto submit(F&& task) -> std::future<std::invoke_result_t<F>>;
+
+    public:
+        [[nodiscard]] size_t size() const { return threads_.size(); }
+
+    private:
+        void enqueue(std::function<void()> task);
+        void run();
+
+    private:
+        std::vector<std::thread> threads_;
+        std::deque<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool stopping_{false};
+};
+
+template <typename F> auto ThreadPool::submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+
+    using R = std::invoke_result_t<F>;
+
+    // std::function needs a copyable target
+    auto packagedTask = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+    auto future = packagedTask->get_future();
+
+    if (threads_.empty()) {
+        (*packagedTask)(); // no workers, run inline
+    } else {
+        enqueue([packagedTask]() { (*packagedTask)(); });
+    }
+
+    return future;
+}
+
+} // namespace
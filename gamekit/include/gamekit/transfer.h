@@ -0,0 +1,69 @@
+/*
+ * Transfer
+ */
+#pragma once
+
+#include <vulkan>
+
+#include "gamekit/types.h"
+#include "gamekit/buffer.h"
+
+#include <vector>
+#include <memory>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// Transfer Batch
+///////////////////////////////////////////////////////////////////////////////
+
+class TransferBatch {
+
+    private:
+        static const size_t npos = (size_t) -1;
+        static const size_t MIN_STAGING_SIZE = 64 * 1024;
+        static const size_t MAX_STAGING_POOL_SIZE = 64 * 1024 * 1024;
+
+    private:
+        struct Submission {
+            CommandBuffer commandBuffer;
+            Fence completed;
+            bool pending{false};
+        };
+
+        struct StagingBuffer {
+            BufferObject buffer;
+            size_t owner{npos};
+        };
+
+    public:
+        TransferBatch() {}
+        TransferBatch(const TransferBatch&) = delete;
+        TransferBatch& operator=(const TransferBatch&) = delete;
+        ~TransferBatch() { destroy(); }
+
+    public:
+        void destroy();
+
+    public:
+        VkCommandBuffer begin();
+        void submit();
+        void flush();
+        void collect();
+        [[nodiscard]] BufferObject& stagingBuffer(size_t size);
+
+    public:
+        [[nodiscard]] bool isRecording() const { return npos != recording_; }
+        [[nodiscard]] bool isPending() const;
+
+    private:
+        void releaseStaging(size_t owner);
+        void trimStaging();
+
+    private:
+        std::vector<Submission> submissions_;
+        std::vector<std::unique_ptr<StagingBuffer>> staging_;
+        size_t recording_{npos};
+};
+
+} // namespace
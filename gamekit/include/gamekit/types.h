@@ -5,12 +5,16 @@
 
 #include "gamekit/reference.h"
 #include "gamekit/primitives.h"
+#include "gamekit/allocator.h"
 
 #include <vulkan>
 
 #include <string>
 #include <vector>
 #include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace gamekit {
 
@@ -46,6 +50,7 @@ class Fence {
         VkResult wait(nanosecond_t timeout=-1) const;
         VkResult waitAndReset(nanosecond_t timeout=-1) const;
         VkResult reset() const;
+        VkResult status() const;
 
     public:
         [[nodiscard]] VkFence ptr() const { return handle_.ptr(); }
@@ -90,7 +95,8 @@ template <> void Reference<VkCommandBuffer>::destroy();
 enum class ShaderType {
     Unknown = 0x0,
     VertexShader = 0x1,
-    FragmentShader = 0x2
+    FragmentShader = 0x2,
+    ComputeShader = 0x3
 };
 
 struct ShaderDescriptor {
@@ -145,31 +151,38 @@ class DeviceMemory {
         };
 
     public:
-        static DeviceMemory make(size_t size, uint32_t typeFilter, uint32_t flags);
-        void destroy() { handle_.free(); }
+        static DeviceMemory make(const VkMemoryRequirements& requirements, uint32_t flags, bool linear=true);
+        void destroy();
 
     public:
-        [[nodiscard]] VkDeviceMemory ptr() const { return handle_.ptr(); }
-        operator VkDeviceMemory() const { return handle_.ptr(); }
+        DeviceMemory() {}
+        DeviceMemory(DeviceMemory&& ref);
+        DeviceMemory& operator=(DeviceMemory&& ref);
+        DeviceMemory(const DeviceMemory&) = delete;
+        DeviceMemory& operator=(const DeviceMemory&) = delete;
+        ~DeviceMemory() { destroy(); }
 
-        [[nodiscard]] size_t size() const { return size_; }
+    public:
+        [[nodiscard]] VkDeviceMemory ptr() const { return allocation_.memory; }
+        operator VkDeviceMemory() const { return allocation_.memory; }
+
+        [[nodiscard]] size_t offset() const { return allocation_.offset; }
+        [[nodiscard]] size_t size() const { return allocation_.size; }
         [[nodiscard]] uint32_t flags() const { return flags_; }
         [[nodiscard]] uint32_t typeFilter() const { return typeFilter_; }
+        [[nodiscard]] bool isDedicated() const { return nullptr == allocation_.block; }
 
     public:
         [[nodiscard]] void* map(size_t ofs, size_t len) const;
         void unmap() const;
 
     private:
-        Reference<VkDeviceMemory> handle_;
-        size_t size_{0};
+        MemoryAllocator::Allocation allocation_{};
         uint32_t flags_{None};
         uint32_t typeFilter_{0};
 
 };
 
-template <> void Reference<VkDeviceMemory>::destroy();
-
 ///////////////////////////////////////////////////////////////////////////////
 // Descriptor Pool
 ///////////////////////////////////////////////////////////////////////////////
@@ -177,6 +190,7 @@ template <> void Reference<VkDeviceMemory>::destroy();
 class DescriptorPool {
     public:
         static DescriptorPool make(size_t size);
+        static DescriptorPool make(const std::vector<VkDescriptorPoolSize>& poolSizes, size_t maxSets, VkDescriptorPoolCreateFlags flags=0);
         void destroy() { handle_.free(); }
 
     public:
@@ -191,6 +205,27 @@ class DescriptorPool {
 
 template <> void Reference<VkDescriptorPool>::destroy();
 
+///////////////////////////////////////////////////////////////////////////////
+// Query Pool
+///////////////////////////////////////////////////////////////////////////////
+
+class QueryPool {
+    public:
+        static QueryPool make(size_t size);
+        void destroy() { handle_.free(); }
+
+    public:
+        [[nodiscard]] VkQueryPool ptr() const { return handle_.ptr(); }
+        [[nodiscard]] size_t size() const { return size_; }
+        operator VkQueryPool() const { return handle_.ptr(); }
+
+    private:
+        Reference<VkQueryPool> handle_;
+        size_t size_{0};
+};
+
+template <> void Reference<VkQueryPool>::destroy();
+
 ///////////////////////////////////////////////////////////////////////////////
 // Descriptor Set
 ///////////////////////////////////////////////////////////////////////////////
@@ -218,16 +253,36 @@ template <> void Reference<VkDescriptorSet>::destroy();
 enum class ImageType {
     Unknown = 0x0,
     PixelBuffer = 0x1,
-    DepthBuffer = 0x2
+    DepthBuffer = 0x2,
+    RenderTarget = 0x3
 };
 
 class Image {
 
+    public:
+        struct Level {
+            size_t offset{0};   // into the uploaded data
+            uint32_t width{0};
+            uint32_t height{0};
+        };
+
+        // cpu side of an image load, decoded without touching the device queue
+        struct Source {
+            std::shared_ptr<const uint8_t> storage;   // decoded pixels, null when data points into the resource
+            const uint8_t* data{nullptr};
+            size_t dataSize{0};
+            std::vector<Level> levels;
+            VkFormat format{VK_FORMAT_UNDEFINED};
+            bool generateMips{false};
+        };
+
     public:
         static Image make(const ResourceDescriptor& resourceDescriptor);
         static Image make(const std::string& filename);
+        static Image make(const Source& source);
         static Image make(ImageType imageType, int width, int height, VkFormat format);
         static Image attach(VkImage image, ImageType imageType, VkFormat format);
+        static Source decode(const ResourceDescriptor& resourceDescriptor);   // thread safe
 
         void destroy() {
             memory_.destroy();
@@ -235,10 +290,15 @@ class Image {
         }
 
     private:
-        void createImage(const void* pixels, int width, int height, int channels, VkFormat format);
-        void createImage(ImageType imageType, int width, int height, VkFormat format);
+        static Source decodePixels(const uint8_t* pixels, int width, int height);
+        static Source decodeCompressed(const ResourceDescriptor& resourceDescriptor);
+
+    private:
+        void createImage(const void* data, size_t dataSize, const std::vector<Level>& levels, VkFormat format, bool generateMips=false);
+        void createImage(ImageType imageType, int width, int height, VkFormat format, uint32_t mipLevels=1);
         void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
-        void copyBufferToImage(VkBuffer buffer, uint32_t width, uint32_t height);
+        void copyBufferToImage(VkBuffer buffer, const std::vector<Level>& levels);
+        void generateMipmaps();     // blits down from level 0, leaves all levels shader readable
 
     public:
         [[nodiscard]] VkImage ptr() const { return handle_.ptr(); }
@@ -246,6 +306,7 @@ class Image {
         [[nodiscard]] int height() const { return height_; }
         [[nodiscard]] int channels() const { return channels_; }
         [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] uint32_t mipLevels() const { return mipLevels_; }
         [[nodiscard]] VkFormat format() const { return format_; }
         [[nodiscard]] ImageType imageType() const { return imageType_; }
         operator VkImage() const { return handle_.ptr(); }
@@ -256,6 +317,7 @@ class Image {
         int height_{0};
         int channels_{0};
         size_t size_{0};
+        uint32_t mipLevels_{1};
         ImageType imageType_{ImageType::Unknown};
         VkFormat format_{VK_FORMAT_UNDEFINED};
         DeviceMemory memory_;
@@ -321,9 +383,21 @@ template <> void Reference<VkFramebuffer>::destroy();
 // Sampler
 ///////////////////////////////////////////////////////////////////////////////
 
+struct SamplerDescription {
+    VkFilter magFilter{VK_FILTER_LINEAR};
+    VkFilter minFilter{VK_FILTER_LINEAR};
+    VkSamplerMipmapMode mipmapMode{VK_SAMPLER_MIPMAP_MODE_LINEAR};
+    VkSamplerAddressMode addressMode{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+    float maxAnisotropy{16.0f};     // clamped to the device limit, 1 or less disables anisotropic filtering
+
+    [[nodiscard]] size_t hash() const;
+    bool operator==(const SamplerDescription& other) const = default;
+};
+
 class Sampler {
     public:
         static Sampler make();
+        static Sampler make(const SamplerDescription& description);
         void destroy() { handle_.free(); }
 
     public:
@@ -335,6 +409,30 @@ class Sampler {
 
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Sampler Cache
+///////////////////////////////////////////////////////////////////////////////
+
+// samplers are few and immutable, equal descriptions share one until the device goes away
+class SamplerCache {
+
+    public:
+        const Sampler& acquire(const SamplerDescription& description);     // thread safe
+        void destroy();
+
+    public:
+        [[nodiscard]] size_t size() const;
+
+    private:
+        struct Entry {
+            SamplerDescription description;
+            Sampler sampler;
+        };
+
+        std::unordered_multimap<size_t, std::unique_ptr<Entry>> samplers_;
+        mutable std::mutex mutex_;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // Others
 ///////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,15 @@
 
 namespace gamekit {
 
+///////////////////////////////////////////////////////////////////////////////
+// Vertex Layout
+///////////////////////////////////////////////////////////////////////////////
+
+enum class VertexLayout {
+    PerVertex = 0x1,        // Vertex, one record per corner
+    QuadInstance = 0x2      // QuadInstance, one record per quad, corners generated in shader
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vertex
 ///////////////////////////////////////////////////////////////////////////////
@@ -98,4 +107,87 @@ class Vertex {
 
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Quad Instance
+///////////////////////////////////////////////////////////////////////////////
+
+class QuadInstance {
+    private:
+        static const size_t NUM_ATTRIBUTES = 5;
+
+    public:
+        glm::vec4 rect_;            // x, y, width, height
+        glm::vec4 texcoords_;       // u, v, width, height
+        uint32_t color_{0x0};       // packed RGBA8, red in the lowest byte
+        uint32_t texmask_{0x0};
+        uint32_t flags_{0x0};
+        uint32_t reserved_{0x0};
+
+    public:
+        void setRect(float x, float y, float w, float h) {
+            rect_.x = x;
+            rect_.y = y;
+            rect_.z = w;
+            rect_.w = h;
+        }
+
+        void setRect(const glm::vec4& rect) {
+            rect_ = rect;
+        }
+
+        void setTexcoords(float u, float v, float w, float h) {
+            texcoords_.x = u;
+            texcoords_.y = v;
+            texcoords_.z = w;
+            texcoords_.w = h;
+        }
+
+        void setTexcoords(const glm::vec4& texcoords) {
+            texcoords_ = texcoords;
+        }
+
+        void setColor(float r, float g, float b, float a) {
+            color_ = packColor(r, g, b, a);
+        }
+
+        void setColor(const glm::vec4& color) {
+            color_ = packColor(color.r, color.g, color.b, color.a);
+        }
+
+        void setTexmask(uint32_t texmask) {
+            texmask_ = texmask;
+        }
+
+        void setFlags(uint32_t flags) {
+            flags_ = flags;
+        }
+
+        void set(float x, float y, float w, float h,
+                 float r, float g, float b, float a,
+                 float tx, float ty, float tw, float th,
+                 uint32_t texmask, uint32_t flags) {
+            setRect(x, y, w, h);
+            setColor(r, g, b, a);
+            setTexcoords(tx, ty, tw, th);
+            texmask_ = texmask;
+            flags_ = flags;
+        }
+
+    public:
+        static uint32_t packColor(float r, float g, float b, float a) {
+            auto toByte = [](float value) -> uint32_t {
+                value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+                return static_cast<uint32_t>(value * 255.0f + 0.5f);
+            };
+            return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (toByte(a) << 24);
+        }
+
+    public:
+        static VkVertexInputBindingDescription getBindingDescription();
+        static std::array<VkVertexInputAttributeDescription, QuadInstance::NUM_ATTRIBUTES> getAttributeDescriptions();
+
+};
+
+static_assert(sizeof(QuadInstance) == 48, "QuadInstance must stay 48 bytes");
+
 } // namespace
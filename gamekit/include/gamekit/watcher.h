@@ -0,0 +1,62 @@
+/*
+ * Watcher
+ */
+#pragma once
+
+#include "gamekit/primitives.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+
+namespace gamekit {
+
+///////////////////////////////////////////////////////////////////////////////
+// File Watcher
+///////////////////////////////////////////////////////////////////////////////
+
+// reports files written below a folder, for development builds. uses
+// inotify on linux and falls back to polling modification times elsewhere
+class FileWatcher {
+
+    public:
+        static const microsecond_t SCAN_INTERVAL = 250000;    // polling fallback only
+
+    public:
+        FileWatcher() {}
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+        FileWatcher(FileWatcher&& other) noexcept;
+        FileWatcher& operator=(FileWatcher&& other) noexcept;
+        ~FileWatcher() { destroy(); }
+
+    public:
+        static FileWatcher make(const std::string& folder);
+        void destroy();
+
+    public:
+        // changed files since the last call, relative to the folder and '/' separated
+        std::vector<std::string> poll();
+
+    public:
+        [[nodiscard]] bool isWatching() const { return !folder_.empty(); }
+        [[nodiscard]] bool isPolling() const { return fd_ < 0; }
+        [[nodiscard]] const std::string& folder() const { return folder_; }
+
+    private:
+        void create(const std::string& folder);
+        void addWatches(const std::filesystem::path& folder);
+        void readEvents(std::vector<std::string>& changes);
+        void scan(std::vector<std::string>* changes);
+
+    private:
+        std::string folder_;
+        int fd_{-1};                                    // inotify instance, -1 when polling
+        std::unordered_map<int, std::string> watches_;  // watch descriptor to relative folder
+        std::unordered_map<std::string, std::filesystem::file_time_type> times_;
+        microsecond_t lastScan_{0};
+};
+
+} // namespace
@@ -0,0 +1,276 @@
+/*
+ * Allocator
+ */
+
+#include <vulkan>
+
+#include "gamekit/allocator.h"
+#include "gamekit/utilities.h"
+
+#include <stdexcept>
+#include <cassert>
+#include <algorithm>
+
+using namespace gamekit;
+
+static size_t alignUp(size_t value, size_t alignment) {
+    if (alignment <= 1) return value;
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory Block
+///////////////////////////////////////////////////////////////////////////////
+
+bool MemoryBlock::alloc(size_t size, size_t alignment, size_t& offset) {
+
+    // first fit over the sorted free list
+    for (size_t i = 0; i < freeList_.size(); i++) {
+        auto& range = freeList_[i];
+
+        auto alignedOffset = alignUp(range.offset, alignment);
+        auto padding = alignedOffset - range.offset;
+        if (range.size < padding + size) continue;
+
+        auto rangeEnd = range.offset + range.size;
+        auto allocEnd = alignedOffset + size;
+
+        if (0 == padding && allocEnd == rangeEnd) {
+            freeList_.erase(freeList_.begin() + i);
+        } else if (0 == padding) {
+            range.offset = allocEnd;
+            range.size = rangeEnd - allocEnd;
+        } else {
+            // keep alignment padding as free range in front of the allocation
+            range.size = padding;
+            if (allocEnd < rangeEnd) {
+                freeList_.insert(freeList_.begin() + i + 1, Range{allocEnd, rangeEnd - allocEnd});
+            }
+        }
+
+        used_ += size;
+        offset = alignedOffset;
+        return true;
+    }
+
+    return false;
+}
+
+void MemoryBlock::free(size_t offset, size_t size) {
+
+    auto it = std::lower_bound(freeList_.begin(), freeList_.end(), offset, [](const Range& range, size_t ofs) {
+        return range.offset < ofs;
+    });
+
+    it = freeList_.insert(it, Range{offset, size});
+    used_ -= size;
+
+    // merge with next range
+    auto next = it + 1;
+    if (next != freeList_.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        freeList_.erase(next);
+    }
+
+    // merge with previous range
+    if (it != freeList_.begin()) {
+        auto prev = it - 1;
+        if (prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            freeList_.erase(it);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory Allocator
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryAllocator::create(VkPhysicalDevice physicalDevice, VkDevice device, size_t blockSize) {
+
+    destroy();
+
+    assert(nullptr != physicalDevice);
+    assert(nullptr != device);
+
+    device_ = device;
+    blockSize_ = blockSize;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties_);
+}
+
+void MemoryAllocator::destroy() {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (nullptr == device_) return;
+
+    for (auto& block : blocks_) {
+        freeMemory(block->handle_, block->mapped_);
+    }
+
+    blocks_.clear();
+    allocationCount_ = 0;
+    dedicatedCount_ = 0;
+    device_ = nullptr;
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propertyFlags) const {
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+bool MemoryAllocator::isHostVisible(uint32_t typeIndex) const {
+    return 0x0 != (memoryProperties_.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+}
+
+MemoryAllocator::Allocation MemoryAllocator::alloc(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags propertyFlags, bool linear) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    assert(nullptr != device_);
+
+    auto typeIndex = findMemoryType(requirements.memoryTypeBits, propertyFlags);
+    auto size = static_cast<size_t>(requirements.size);
+    auto alignment = static_cast<size_t>(requirements.alignment);
+
+    Allocation allocation;
+    allocation.size = size;
+
+    // large resources get their own allocation instead of fragmenting the pool
+    if (size > blockSize_ / 4) {
+        allocation.memory = allocMemory(size, typeIndex, &allocation.mapped);
+        allocation.offset = 0;
+        dedicatedCount_++;
+        allocationCount_++;
+        return allocation;
+    }
+
+    // linear and optimal resources live in separate blocks, so
+    // bufferImageGranularity never applies between neighbours
+    MemoryBlock* block = nullptr;
+    size_t offset = 0;
+
+    for (auto& candidate : blocks_) {
+        if (candidate->typeIndex_ != typeIndex || candidate->linear_ != linear) continue;
+        if (candidate->size_ - candidate->used_ < size) continue;
+        if (candidate->alloc(size, alignment, offset)) {
+            block = candidate.get();
+            break;
+        }
+    }
+
+    if (nullptr == block) {
+        auto& newBlock = blocks_.emplace_back(std::make_unique<MemoryBlock>());
+        newBlock->handle_ = allocMemory(blockSize_, typeIndex, &newBlock->mapped_);
+        newBlock->size_ = blockSize_;
+        newBlock->typeIndex_ = typeIndex;
+        newBlock->linear_ = linear;
+        newBlock->freeList_.push_back(MemoryBlock::Range{0, blockSize_});
+
+        block = newBlock.get();
+        if (!block->alloc(size, alignment, offset)) {
+            throw std::runtime_error("Failed to sub-allocate device memory");
+        }
+    }
+
+    allocation.memory = block->handle_;
+    allocation.block = block;
+    allocation.offset = offset;
+    if (nullptr != block->mapped_) {
+        allocation.mapped = static_cast<uint8_t*>(block->mapped_) + offset;
+    }
+
+    allocationCount_++;
+
+    return allocation;
+}
+
+void MemoryAllocator::free(const Allocation& allocation) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (nullptr == device_ || nullptr == allocation.memory) return;
+
+    allocationCount_--;
+
+    if (nullptr == allocation.block) {
+        freeMemory(allocation.memory, allocation.mapped);
+        dedicatedCount_--;
+        return;
+    }
+
+    auto block = allocation.block;
+    block->free(allocation.offset, allocation.size);
+
+    if (!block->empty()) return;
+
+    // release empty blocks, but keep one per memory pool to avoid churn
+    for (const auto& other : blocks_) {
+        if (other.get() == block) continue;
+        if (other->typeIndex_ == block->typeIndex_ && other->linear_ == block->linear_) {
+            auto it = std::find_if(blocks_.begin(), blocks_.end(), [block](const auto& entry) {
+                return entry.get() == block;
+            });
+            freeMemory(block->handle_, block->mapped_);
+            blocks_.erase(it);
+            return;
+        }
+    }
+}
+
+MemoryAllocator::Statistics MemoryAllocator::statistics() const {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Statistics stats;
+    stats.blockCount = blocks_.size();
+    stats.dedicatedCount = dedicatedCount_;
+    stats.allocationCount = allocationCount_;
+
+    for (const auto& block : blocks_) {
+        stats.reservedSize += block->size_;
+        stats.usedSize += block->used_;
+    }
+
+    return stats;
+}
+
+VkDeviceMemory MemoryAllocator::allocMemory(size_t size, uint32_t typeIndex, void** mapped) {
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = typeIndex;
+
+    VkDeviceMemory memory{nullptr};
+
+    auto res = vkAllocateMemory(device_, &allocInfo, nullptr, &memory);
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to allocate device memory: err={}", (int) res));
+    }
+
+    // host visible memory stays mapped for its whole lifetime
+    *mapped = nullptr;
+    if (isHostVisible(typeIndex)) {
+        res = vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+        if (VK_SUCCESS != res) {
+            vkFreeMemory(device_, memory, nullptr);
+            throw std::runtime_error(Format::str("Failed to map device memory: err={}", (int) res));
+        }
+    }
+
+    return memory;
+}
+
+void MemoryAllocator::freeMemory(VkDeviceMemory memory, void* mapped) {
+    if (nullptr != mapped) {
+        vkUnmapMemory(device_, memory);
+    }
+    vkFreeMemory(device_, memory, nullptr);
+}
@@ -46,6 +46,10 @@ float Api::absTime() const {
     return application->absTime();
 }
 
+float Api::interpolation() const {
+    return application->interpolation();
+}
+
 void Api::addMaterial(Material& material) {
     device->addMaterial(material);
 }
@@ -58,6 +62,22 @@ Material* Api::material() {
     return device->material();
 }
 
+void Api::addComputeMaterial(ComputeMaterial& computeMaterial) {
+    device->addComputeMaterial(computeMaterial);
+}
+
+RenderQueue& Api::renderQueue() {
+    return device->renderQueue();
+}
+
+TextureTable& Api::textureTable() {
+    return device->textureTable();
+}
+
+bool Api::isBindlessSupported() const {
+    return device->isBindlessSupported();
+}
+
 const Metrics& Api::metrics() const {
     return device->metrics();
 }
@@ -66,6 +86,14 @@ const Frame& Api::currentFrame() const {
     return device->currentFrame();
 }
 
+const std::vector<GpuProfiler::Result>& Api::gpuTimings() const {
+    return device->profiler().results();
+}
+
+double Api::gpuFrameTime() const {
+    return device->profiler().frameTime();
+}
+
 const Resources& Api::resources() const {
     return application->resources();
 }
@@ -77,3 +105,7 @@ Resources& Api::resources() {
 const ResourceDescriptor& Api::resources(const std::string& id) const {
     return application->resources().get(id);
 }
+
+const ResourceDescriptor& Api::resources(ResourceId id) const {
+    return application->resources().get(id);
+}
@@ -7,8 +7,14 @@
 #include "gamekit/types.h"
 #include "gamekit/clock.h"
 #include "gamekit/api.h"
+#include "gamekit/loader.h"
+#include "gamekit/utilities.h"
 
 #include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 
 const bool enableErrorChecking = true;
 
@@ -28,6 +34,7 @@ ApplicationBase::ApplicationBase(const char* windowTitle, int windowWidth, int w
 }
 
 ApplicationBase::~ApplicationBase() {
+    stopSimulation();
     if (this == global_instance_) {
         global_instance_ = nullptr;
     }
@@ -37,17 +44,68 @@ ApplicationBase* ApplicationBase::globalInstance() {
     return global_instance_;
 }
 
+void ApplicationBase::configure(int argc, const char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (0 == strcmp(arg, "--headless")) {
+            setHeadless(true);
+        } else if (0 == strcmp(arg, "--frames") && i + 1 < argc) {
+            setFrameLimit((size_t) std::strtoull(argv[++i], nullptr, 10));
+        } else if (0 == strcmp(arg, "--capture") && i + 1 < argc) {
+            setCaptureFile(argv[++i]);
+        } else if (0 == strcmp(arg, "--benchmark") && i + 1 < argc) {
+            setBenchmark((size_t) std::strtoull(argv[++i], nullptr, 10), benchmarkFile_);
+        } else if (0 == strcmp(arg, "--benchmark-json") && i + 1 < argc) {
+            benchmarkFile_ = argv[++i];
+        } else if (0 == strcmp(arg, "--tick-rate") && i + 1 < argc) {
+            setFixedTimestep(std::atoi(argv[++i]), maxSteps_);
+        } else if (0 == strcmp(arg, "--sim-thread")) {
+            setSimulationThread(true);
+        }
+    }
+}
+
+void ApplicationBase::setFixedTimestep(int tickRate, int maxSteps) {
+    tickTime_ = (tickRate > 0) ? 1000000LL / (int64_t) tickRate : 0;
+    maxSteps_ = (maxSteps > 0) ? maxSteps : 1;
+    deltaTime_ = (float) tickTime_ / 1000000.0f;
+    interpolation_ = 1.0f;
+}
+
+void ApplicationBase::setBenchmark(size_t frameCount, const std::string& jsonFile) {
+    benchmarkFrames_ = frameCount;
+    benchmarkFile_ = jsonFile;
+    frameLimit_ = frameCount;
+}
+
 void ApplicationBase::init() {
 
     running_ = false;
+    frameCounter_ = 0;
+
+    // compiled pipelines survive restarts, see PipelineCache
+    auto prefPath = Environment::getPrefPath("gamekit", windowTitle_);
+    if (!prefPath.empty()) {
+        device.setPipelineCacheFile(prefPath + "pipeline.cache");
+    }
 
-    window_.create(windowTitle_.c_str(), windowWidth_, windowHeight_);
-    device.createDevice(window_, enableErrorChecking);
+    if (headless_) {
+        Loader::instance()->loadHeadless();
+        device.setReadback(!captureFile_.empty());
+        device.createHeadlessDevice(windowWidth_, windowHeight_, enableErrorChecking);
+    } else {
+        window_.create(windowTitle_.c_str(), windowWidth_, windowHeight_);
+        device.createDevice(window_, enableErrorChecking);
+    }
 
     createResources();
 
     api_.create();
 
+    if (isBenchmark()) {
+        device.setGpuProfiling(true);
+    }
+
     userInit();
 
     device.createRenderer();
@@ -67,7 +125,12 @@ void ApplicationBase::shutdown() {
     api_.destroy();
 
     device.destroyDevice();
-    window_.destroy();
+
+    if (headless_) {
+        Loader::instance()->unload();
+    } else {
+        window_.destroy();
+    }
 }
 
 void ApplicationBase::run() {
@@ -84,16 +147,30 @@ void ApplicationBase::run() {
 
     microsecond_t now = 0;
 
+    if (isBenchmark()) {
+        benchmark_.create(benchmarkFrames_);
+    }
+
+    // benchmarks keep the ticks on the render thread to measure them
+    if (isFixedTimestep() && simulationThread_ && !isBenchmark()) {
+        startSimulation();
+    }
+
     while (running_) {
 
         while (running_) {
 
-            if (!window_.processEvents()) {
+            if (!headless_ && !window_.processEvents()) {
                 running_ = false;
                 break;
             }
 
             now = Clock::getTime();
+
+            if (isBenchmark()) {
+                break; // uncapped frame rate
+            }
+
             if (now >= next_cycle) {
                 next_cycle += cycle_time;
                 if (next_cycle < now + min_cycle_time) {
@@ -106,10 +183,21 @@ void ApplicationBase::run() {
             Clock::sleep(sleep_time > max_sleep_time ? max_sleep_time : sleep_time);
         }
 
-        absTime_ = (float) now * 0.000001f;
-        auto delta = (lastUpdateTime != 0) ? now - lastUpdateTime : 0;
-        deltaTime_ = (float) delta / 1000000.0f;
-        lastUpdateTime = now;
+        if (!isFixedTimestep()) {
+            absTime_ = (float) now * 0.000001f;
+            auto delta = (lastUpdateTime != 0) ? now - lastUpdateTime : 0;
+            deltaTime_ = (float) delta / 1000000.0f;
+            lastUpdateTime = now;
+        }
+
+        if (!running_) {
+            break;
+        }
+
+        if (isBenchmark()) {
+            runBenchmarkFrame();
+            continue;
+        }
 
         update();
 
@@ -117,6 +205,11 @@ void ApplicationBase::run() {
             draw();
             device.end();
             updateStatistics();
+
+            frameCounter_++;
+            if (frameLimit_ > 0 && frameCounter_ >= frameLimit_) {
+                running_ = false;
+            }
         } else {
             // no drawing (minimized) -> idle state - waiting for events
             window_.waitEvents();
@@ -124,17 +217,171 @@ void ApplicationBase::run() {
 
     }
 
+    stopSimulation();
+
+    if (!captureFile_.empty()) {
+        capture();
+    }
+
+    if (isBenchmark()) {
+        benchmark_.print(std::cout);
+        if (!benchmarkFile_.empty() && !benchmark_.writeJson(benchmarkFile_)) {
+            std::cout << "failed to write benchmark results: " << benchmarkFile_ << std::endl;
+        }
+    }
+
     shutdown();
 }
 
+void ApplicationBase::runBenchmarkFrame() {
+
+    auto t0 = Clock::getTimeNs();
+
+    update();
+
+    auto t1 = Clock::getTimeNs();
+
+    if (!device.begin(window_)) {
+        window_.waitEvents();
+        return; // minimized frames are not measured
+    }
+
+    auto t2 = Clock::getTimeNs();
+
+    draw();
+
+    auto t3 = Clock::getTimeNs();
+
+    device.end();
+
+    auto t4 = Clock::getTimeNs();
+
+    benchmark_.record(Benchmark::Update, t1 - t0);
+    benchmark_.record(Benchmark::BeginDraw, t2 - t1);
+    benchmark_.record(Benchmark::Draw, t3 - t2);
+    benchmark_.record(Benchmark::EndDraw, t4 - t3);
+    benchmark_.record(Benchmark::Frame, t4 - t0);
+
+    // gpu results of earlier frames arrive once their frame slot is reused
+    const auto& profiler = device.profiler();
+    if (profiler.resolvedFrames() != benchmarkGpuFrames_) {
+        benchmarkGpuFrames_ = profiler.resolvedFrames();
+        benchmark_.record(Benchmark::GpuFrame, (nanosecond_t) (profiler.frameTime() * 1000.0));
+    }
+
+    benchmark_.endFrame();
+
+    frameCounter_++;
+    if (frameCounter_ >= frameLimit_) {
+        running_ = false;
+    }
+}
+
 void ApplicationBase::update() {
-    userUpdate();
+
+    if (simulation_.joinable()) {
+        // ticks may request resources, uploads must not run concurrently
+        std::lock_guard<std::mutex> lock(simulationMutex_);
+        resources_.update();
+        return;
+    }
+
+    resources_.update(); // uploads finished async loads before user code sees them
+
+    if (isFixedTimestep()) {
+        advance(Clock::getTime());
+    } else {
+        userUpdate();
+    }
 }
 
 void ApplicationBase::draw() {
+
+    if (!isFixedTimestep()) {
+        userDraw();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(simulationMutex_, std::defer_lock);
+    if (simulation_.joinable()) {
+        lock.lock();
+    }
+
+    if (simulationError_) {
+        std::rethrow_exception(simulationError_);
+    }
+
+    // time since the last advance already counts towards the next tick
+    auto pending = accumulator_;
+    if (simulation_.joinable()) {
+        pending += Clock::getTime() - lastAdvance_;
+    }
+
+    interpolation_ = std::clamp((float) pending / (float) tickTime_, 0.0f, 1.0f);
+
     userDraw();
 }
 
+void ApplicationBase::advance(microsecond_t now) {
+
+    // the first advance runs one tick, onDraw never sees a state without update
+    accumulator_ += (0 != lastAdvance_) ? now - lastAdvance_ : tickTime_;
+    lastAdvance_ = now;
+
+    for (int steps = 0; accumulator_ >= tickTime_ && steps < maxSteps_; steps++) {
+        tickCount_++;
+        absTime_ = (float) ((double) tickCount_ * (double) tickTime_ * 0.000001);
+        userUpdate();
+        accumulator_ -= tickTime_;
+    }
+
+    // too slow to catch up: the backlog is dropped instead of growing without
+    // bound, the simulation then runs slower than real time but stays stable
+    if (accumulator_ >= tickTime_) {
+        accumulator_ %= tickTime_;
+    }
+}
+
+void ApplicationBase::startSimulation() {
+
+    // first tick on the calling thread, before the first frame is drawn
+    advance(Clock::getTime());
+
+    simulating_ = true;
+    simulation_ = std::thread(&ApplicationBase::simulate, this);
+}
+
+void ApplicationBase::stopSimulation() {
+    if (!simulation_.joinable()) return;
+    simulating_ = false;
+    simulation_.join();
+}
+
+void ApplicationBase::simulate() {
+
+    const microsecond_t max_sleep_time = 10000;
+
+    while (simulating_) {
+
+        microsecond_t sleep_time = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(simulationMutex_);
+
+            try {
+                advance(Clock::getTime());
+            } catch (...) {
+                simulationError_ = std::current_exception(); // rethrown by the next draw
+                return;
+            }
+
+            sleep_time = tickTime_ - accumulator_;
+        }
+
+        Clock::sleep(sleep_time > max_sleep_time ? max_sleep_time : sleep_time);
+    }
+}
+
 void ApplicationBase::updateStatistics() {
 
     stats.updateCounter++;
@@ -149,3 +396,20 @@ void ApplicationBase::updateStatistics() {
         std::cout << "fps: " << stats.avgUpdatesPerSecond << std::endl;
     }
 }
+
+void ApplicationBase::capture() {
+
+    std::vector<uint8_t> pixels;
+    if (!device.readback(pixels)) {
+        std::cout << "capture not available: " << captureFile_ << std::endl;
+        return;
+    }
+
+    // binary PPM of the last rendered frame, alpha channel dropped
+    const auto& metrics = device.metrics();
+    std::ofstream out(captureFile_, std::ios::binary);
+    out << "P6\n" << metrics.width << " " << metrics.height << "\n255\n";
+    for (size_t ofs = 0; ofs + 3 < pixels.size(); ofs += 4) {
+        out.write(reinterpret_cast<const char*>(&pixels[ofs]), 3);
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * Atlas
+ */
+
+#include "gamekit/atlas.h"
+#include "gamekit/utilities.h"
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <stdexcept>
+
+using namespace gamekit;
+
+Atlas Atlas::make(const ResourceDescriptor& resourceDescriptor) {
+    Atlas atlas;
+    atlas.create(resourceDescriptor);
+    return atlas;
+}
+
+void Atlas::create(const ResourceDescriptor& resourceDescriptor) {
+
+    pages_.clear();
+    frames_.clear();
+    index_.clear();
+
+    // line based table written by gamekitc:
+    // page <resource> <width> <height>
+    // frame <name> <page> <x> <y> <width> <height>
+    std::string_view text(static_cast<const char*>(resourceDescriptor.data), resourceDescriptor.dataSize);
+    std::istringstream stream{std::string(text)};
+    std::string line;
+
+    while (std::getline(stream, line)) {
+
+        std::istringstream fields(line);
+        std::string tag;
+        fields >> tag;
+
+        if (tag == "page") {
+            Page page;
+            fields >> page.name >> page.width >> page.height;
+            if (fields.fail() || 0 == page.width || 0 == page.height) {
+                throw std::runtime_error(Format::str("invalid atlas page", line.c_str()));
+            }
+            pages_.push_back(page);
+
+        } else if (tag == "frame") {
+            std::string name;
+            uint32_t page = 0, x = 0, y = 0, w = 0, h = 0;
+            fields >> name >> page >> x >> y >> w >> h;
+            if (fields.fail() || page >= pages_.size()) {
+                throw std::runtime_error(Format::str("invalid atlas frame", line.c_str()));
+            }
+
+            const auto& pageInfo = pages_[page];
+            auto pw = (float) pageInfo.width;
+            auto ph = (float) pageInfo.height;
+
+            Frame frame;
+            frame.page = page;
+            frame.texcoords = glm::vec4((float) x / pw, (float) y / ph, (float) w / pw, (float) h / ph);
+            frame.size = glm::vec2((float) w, (float) h);
+
+            index_[name] = frames_.size();
+            frames_.push_back(frame);
+        }
+    }
+}
+
+size_t Atlas::frameIndex(const std::string& name) const {
+    auto it = index_.find(name);
+    return (it != index_.end()) ? it->second : npos;
+}
+
+const Atlas::Frame* Atlas::find(const std::string& name) const {
+    auto index = frameIndex(name);
+    return (index != npos) ? &frames_[index] : nullptr;
+}
+
+const Atlas::Frame& Atlas::get(const std::string& name) const {
+    auto frame = find(name);
+    if (nullptr == frame) {
+        throw std::runtime_error(Format::str("could not find atlas frame", name.c_str()));
+    }
+    return *frame;
+}
@@ -0,0 +1,146 @@
+/*
+ * Benchmark
+ */
+
+#include "gamekit/benchmark.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+
+using namespace gamekit;
+
+static double percentile(const std::vector<nanosecond_t>& sorted, double p) {
+    // nearest rank
+    if (sorted.empty()) return 0.0;
+    auto rank = (size_t) std::ceil(p * (double) sorted.size());
+    if (rank > 0) rank--;
+    return (double) sorted[std::min(rank, sorted.size() - 1)];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmark
+///////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::create(size_t frameCount) {
+    reset();
+    for (auto& samples : samples_) {
+        samples.reserve(frameCount);
+    }
+}
+
+void Benchmark::reset() {
+    for (auto& samples : samples_) {
+        samples.clear();
+    }
+    frameCounter_ = 0;
+}
+
+void Benchmark::record(Phase phase, nanosecond_t duration) {
+    samples_[phase].push_back(duration);
+}
+
+Benchmark::Summary Benchmark::summary(Phase phase) const {
+
+    Summary summary;
+
+    const auto& samples = samples_[phase];
+    if (samples.empty()) return summary;
+
+    auto sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (auto value : sorted) sum += (double) value;
+
+    // values in microseconds
+    const double scale = 0.001;
+
+    summary.count = sorted.size();
+    summary.min = (double) sorted.front() * scale;
+    summary.max = (double) sorted.back() * scale;
+    summary.mean = sum / (double) sorted.size() * scale;
+    summary.median = percentile(sorted, 0.50) * scale;
+    summary.p95 = percentile(sorted, 0.95) * scale;
+    summary.p99 = percentile(sorted, 0.99) * scale;
+
+    return summary;
+}
+
+const char* Benchmark::phaseName(Phase phase) {
+    switch (phase) {
+        case Update: return "update";
+        case BeginDraw: return "beginDraw";
+        case Draw: return "draw";
+        case EndDraw: return "endDraw";
+        case Frame: return "frame";
+        case GpuFrame: return "gpuFrame";
+        default: return "unknown";
+    }
+}
+
+void Benchmark::print(std::ostream& out) const {
+
+    out << "benchmark: " << frameCounter_ << " frames (times in us)" << std::endl;
+    out << std::setw(12) << "phase"
+        << std::setw(10) << "min"
+        << std::setw(10) << "median"
+        << std::setw(10) << "mean"
+        << std::setw(10) << "p95"
+        << std::setw(10) << "p99"
+        << std::setw(10) << "max" << std::endl;
+
+    out << std::fixed << std::setprecision(1);
+
+    for (int i = 0; i < PhaseCount; i++) {
+        auto phase = (Phase) i;
+        auto s = summary(phase);
+        out << std::setw(12) << phaseName(phase)
+            << std::setw(10) << s.min
+            << std::setw(10) << s.median
+            << std::setw(10) << s.mean
+            << std::setw(10) << s.p95
+            << std::setw(10) << s.p99
+            << std::setw(10) << s.max << std::endl;
+    }
+
+    out << std::defaultfloat;
+}
+
+std::string Benchmark::toJson() const {
+
+    nlohmann::json doc;
+    doc["frames"] = frameCounter_;
+    doc["unit"] = "us";
+
+    for (int i = 0; i < PhaseCount; i++) {
+        auto phase = (Phase) i;
+        auto s = summary(phase);
+
+        auto& entry = doc["phases"][phaseName(phase)];
+        entry["min"] = s.min;
+        entry["max"] = s.max;
+        entry["mean"] = s.mean;
+        entry["median"] = s.median;
+        entry["p95"] = s.p95;
+        entry["p99"] = s.p99;
+
+        // raw per-frame samples, to tell hitches from steady state
+        auto& values = entry["samples"] = nlohmann::json::array();
+        for (auto value : samples_[phase]) {
+            values.push_back((double) value * 0.001);
+        }
+    }
+
+    return doc.dump(2);
+}
+
+bool Benchmark::writeJson(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) return false;
+    out << toJson() << std::endl;
+    return out.good();
+}
@@ -7,6 +7,7 @@
 #include "gamekit/material.h"
 #include "gamekit/buffer.h"
 #include "gamekit/device.h"
+#include "gamekit/utilities.h"
 
 #include <stdexcept>
 #include <cassert>
@@ -131,6 +132,7 @@ BufferObject::BufferObject(BufferObject&& ref) {
     size_ = ref.size_; ref.size_ = 0;
     handle_ = ref.handle_; ref.handle_ = nullptr;
     memory_ = std::move(ref.memory_);
+    mapped_ = ref.mapped_; ref.mapped_ = nullptr;
 }
 
 BufferObject& BufferObject::operator=(BufferObject&& ref) {
@@ -143,6 +145,7 @@ BufferObject& BufferObject::operator=(BufferObject&& ref) {
     size_ = ref.size_; ref.size_ = 0;
     handle_ = ref.handle_; ref.handle_ = nullptr;
     memory_ = std::move(ref.memory_);
+    mapped_ = ref.mapped_; ref.mapped_ = nullptr;
 
     return *this;
 }
@@ -175,11 +178,12 @@ void BufferObject::create(BufferType bufferType, size_t size, uint32_t bufferUsa
         VkMemoryRequirements memRequirements{};
         vkGetBufferMemoryRequirements(device, handle_, &memRequirements);
 
-        memory_ = DeviceMemory::make(memRequirements.size,
-                                     memRequirements.memoryTypeBits,
-                                     memoryUsage);
+        memory_ = DeviceMemory::make(memRequirements, memoryUsage);
 
-        vkBindBufferMemory(device, handle_, memory_, 0);
+        auto res = vkBindBufferMemory(device, handle_, memory_.ptr(), memory_.offset());
+        if (VK_SUCCESS != res) {
+            throw std::runtime_error(Format::str("Failed to bind buffer memory: err={}", (int) res));
+        }
     }
 
 }
@@ -189,6 +193,11 @@ void BufferObject::destroy() {
 
     auto device = Device::globalHandle();
 
+    if (nullptr != mapped_) {
+        memory_.unmap();
+        mapped_ = nullptr;
+    }
+
     memory_.destroy();
     vkDestroyBuffer(device, handle_, nullptr);
     handle_ = nullptr;
@@ -239,11 +248,24 @@ void BufferObject::unmap() const {
     return memory_.unmap();
 }
 
+void* BufferObject::mapPersistent() {
+    // keep the whole buffer mapped until destroy(), only valid for host visible memory
+    if (nullptr == mapped_) {
+        mapped_ = map();
+    }
+    return mapped_;
+}
+
 void BufferObject::copy(const void* source_ptr) const {
     copy(source_ptr, size_);
 }
 
 void BufferObject::copy(const void* source_ptr, size_t len) const {
+    if (nullptr != mapped_) {
+        std::memcpy(mapped_, source_ptr, len);
+        return;
+    }
+
     void* dest_ptr = map();
     std::memcpy(dest_ptr, source_ptr, len);
     unmap();
@@ -263,48 +285,17 @@ void BufferObject::copy(const BufferObject& src, size_t len) const {
     auto deviceObj = Device::globalInstance();
     assert(nullptr != deviceObj);
 
-    auto device = deviceObj->handle();
-    assert(nullptr != device);
-
-    auto commandPool = deviceObj->commandPool();
-    assert(nullptr != commandPool);
-
-    auto graphicsQueue = deviceObj->graphicsQueue();
-    assert(nullptr != graphicsQueue);
-
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    // recorded into the pending transfer batch, submitted ahead of the next frame
+    VkCommandBuffer commandBuffer = deviceObj->beginCommand();
 
     VkBufferCopy copyRegion{};
     copyRegion.srcOffset = 0; // Optional
     copyRegion.dstOffset = 0; // Optional
-    copyRegion.size = src.size_;
+    copyRegion.size = len;
 
     vkCmdCopyBuffer(commandBuffer, srcBuffer, destBuffer, 1, &copyRegion);
 
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    deviceObj->endCommand(commandBuffer);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -315,7 +306,7 @@ VertexBuffer VertexBuffer::make(size_t size) {
     VertexBuffer buffer;
     buffer.create(0, BufferType::VertexBuffer, size);
 
-    // device memory
+    // device memory, uploaded through pooled staging memory of the transfer batch
     buffer.bufferObjects_.emplace_back(BufferObject::make(
         BufferType::VertexBuffer,
         size,
@@ -323,13 +314,26 @@ VertexBuffer VertexBuffer::make(size_t size) {
         DeviceMemory::DeviceLocalMemory)
     );
 
-    // staging memory
-    buffer.bufferObjects_.emplace_back(BufferObject::make(
-        BufferType::StagingBuffer,
-        size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
-    );
+    return std::move(buffer);
+}
+
+VertexBuffer VertexBuffer::makeStreaming(size_t size) {
+    VertexBuffer buffer;
+    buffer.create(0, BufferType::VertexBuffer, size);
+    buffer.flags_ |= Streaming;
+
+    // one persistently mapped host memory region per in-flight frame,
+    // written directly by the cpu and read by the gpu without staging
+    auto numFrames = Device::globalInstance()->frameCount();
+    for (size_t frameIndex = 0; frameIndex < numFrames; frameIndex++) {
+        auto& bufferObject = buffer.bufferObjects_.emplace_back(BufferObject::make(
+            BufferType::VertexBuffer,
+            size,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
+        );
+        bufferObject.mapPersistent();
+    }
 
     return std::move(buffer);
 }
@@ -339,16 +343,42 @@ void VertexBuffer::copy(const void* sourcePtr) {
 }
 
 void VertexBuffer::copy(const void* sourcePtr, size_t len) {
-    assert(bufferObjects_.size() >=2 );
-    bufferObjects_[1].copy(sourcePtr, len);              // copy to staging buffer
-    bufferObjects_[0].copy(bufferObjects_[1], len);      // copy to device memory
+    if (isStreaming()) {
+        const auto& frame = Device::globalInstance()->currentFrame();
+        std::memcpy(data(frame.index), sourcePtr, len);
+        return;
+    }
+
+    assert(bufferObjects_.size() >=1 );
+    auto& stagingBuffer = Device::globalInstance()->transfers().stagingBuffer(len);
+    stagingBuffer.copy(sourcePtr, len);                  // copy to staging buffer
+    bufferObjects_[0].copy(stagingBuffer, len);          // copy to device memory
 }
 
 void VertexBuffer::bind() const {
     assert(bufferObjects_.size() >=1 );
+    if (isStreaming()) {
+        const auto& frame = Device::globalInstance()->currentFrame();
+        bufferObjects_[frame.index].bind();
+        return;
+    }
     bufferObjects_[0].bind();
 }
 
+VkBuffer VertexBuffer::handle() const {
+    assert(bufferObjects_.size() >=1 );
+    if (isStreaming()) {
+        const auto& frame = Device::globalInstance()->currentFrame();
+        return bufferObjects_[frame.index];
+    }
+    return bufferObjects_[0];
+}
+
+void* VertexBuffer::data(size_t frameIndex) const {
+    assert(isStreaming() && frameIndex < bufferObjects_.size());
+    return bufferObjects_[frameIndex].mapped();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Index Buffer
 ///////////////////////////////////////////////////////////////////////////////
@@ -357,7 +387,7 @@ IndexBuffer IndexBuffer::make(size_t size) {
     IndexBuffer buffer;
     buffer.create(0, BufferType::IndexBuffer, size);
 
-    // device memory
+    // device memory, uploaded through pooled staging memory of the transfer batch
     buffer.bufferObjects_.emplace_back(BufferObject::make(
         BufferType::IndexBuffer,
         size,
@@ -365,21 +395,14 @@ IndexBuffer IndexBuffer::make(size_t size) {
         DeviceMemory::DeviceLocalMemory)
     );
 
-    // staging memory
-    buffer.bufferObjects_.emplace_back(BufferObject::make(
-        BufferType::StagingBuffer,
-        size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
-    );
-
     return std::move(buffer);
 }
 
 void IndexBuffer::copy(const void* sourcePtr) {
-    assert(bufferObjects_.size() >=2 );
-    bufferObjects_[1].copy(sourcePtr);              // copy to staging buffer
-    bufferObjects_[0].copy(bufferObjects_[1]);      // copy to device memory
+    assert(bufferObjects_.size() >=1 );
+    auto& stagingBuffer = Device::globalInstance()->transfers().stagingBuffer(size_);
+    stagingBuffer.copy(sourcePtr, size_);               // copy to staging buffer
+    bufferObjects_[0].copy(stagingBuffer, size_);       // copy to device memory
 }
 
 void IndexBuffer::bind() const {
@@ -387,6 +410,11 @@ void IndexBuffer::bind() const {
     bufferObjects_[0].bind();
 }
 
+VkBuffer IndexBuffer::handle() const {
+    assert(bufferObjects_.size() >=1 );
+    return bufferObjects_[0];
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Uniform Buffer
 ///////////////////////////////////////////////////////////////////////////////
@@ -409,16 +437,19 @@ void UniformBuffer::bind() const {
     bufferObject.bind();
 }
 
-BufferObject& UniformBuffer::allocFrameBuffer() {
-    // alloc per-frame uniform buffer object
-    auto& bufferObject = bufferObjects_.emplace_back(BufferObject::make(
-        BufferType::UniformBuffer,
-        size_,
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
-    );
+BufferObject& UniformBuffer::allocFrameBuffer(size_t frameIndex) {
+    // alloc per-frame uniform buffer objects on first use, materials
+    // sharing the buffer get the same object for the same frame
+    while (bufferObjects_.size() <= frameIndex) {
+        bufferObjects_.emplace_back(BufferObject::make(
+            BufferType::UniformBuffer,
+            size_,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
+        );
+    }
 
-    return bufferObject;
+    return bufferObjects_[frameIndex];
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -431,28 +462,69 @@ ShaderStorageBuffer ShaderStorageBuffer::make(uint32_t index, size_t size) {
     return std::move(buffer);
 }
 
+ShaderStorageBuffer ShaderStorageBuffer::makeDeviceLocal(uint32_t index, size_t size) {
+    ShaderStorageBuffer buffer;
+    buffer.create(index, BufferType::ShaderStorageBuffer, size);
+    buffer.flags_ |= DeviceLocal;
+
+    // single gpu resident buffer shared by all frames, written by compute
+    // shaders and consumable as vertex input without a cpu round-trip
+    buffer.bufferObjects_.emplace_back(BufferObject::make(
+        BufferType::ShaderStorageBuffer,
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        DeviceMemory::DeviceLocalMemory)
+    );
+
+    return std::move(buffer);
+}
+
 void ShaderStorageBuffer::copy(const void* sourcePtr) {
+    if (isDeviceLocal()) {
+        auto& stagingBuffer = Device::globalInstance()->transfers().stagingBuffer(size_);
+        stagingBuffer.copy(sourcePtr, size_);               // copy to staging buffer
+        bufferObjects_[0].copy(stagingBuffer, size_);       // copy to device memory
+        return;
+    }
+
     const auto& frame = Device::globalInstance()->currentFrame();
     const auto& bufferObject = bufferObjects_[frame.index];
     bufferObject.copy(sourcePtr);
 }
 
 void ShaderStorageBuffer::bind() const {
+    if (isDeviceLocal()) {
+        // bind as vertex input, e.g. instance records produced by a compute pass
+        assert(bufferObjects_.size() >= 1);
+        const auto& frame = Device::globalInstance()->currentFrame();
+        VkBuffer handle = bufferObjects_[0];
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(frame.commandBuffer, 0, 1, &handle, &offset);
+        return;
+    }
+
     const auto& frame = Device::globalInstance()->currentFrame();
     const auto& bufferObject = bufferObjects_[frame.index];
     bufferObject.bind();
 }
 
-BufferObject& ShaderStorageBuffer::allocFrameBuffer() {
-    // alloc per-frame storage buffer object
-    auto& bufferObject = bufferObjects_.emplace_back(BufferObject::make(
-        BufferType::ShaderStorageBuffer,
-        size_,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
-    );
+BufferObject& ShaderStorageBuffer::allocFrameBuffer(size_t frameIndex) {
+    if (isDeviceLocal()) {
+        return bufferObjects_[0];
+    }
 
-    return bufferObject;
+    // alloc per-frame storage buffer objects on first use, see UniformBuffer
+    while (bufferObjects_.size() <= frameIndex) {
+        auto& bufferObject = bufferObjects_.emplace_back(BufferObject::make(
+            BufferType::ShaderStorageBuffer,
+            size_,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory)
+        );
+        bufferObject.mapPersistent();
+    }
+
+    return bufferObjects_[frameIndex];
 }
 
 void PushConstantsBase::push() const {
@@ -28,3 +28,9 @@ microsecond_t Clock::getTime() {
 
     return (t - time_offset);
 }
+
+nanosecond_t Clock::getTimeNs() {
+    // monotonic, for measuring intervals only
+    auto duration = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
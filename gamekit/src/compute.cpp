@@ -0,0 +1,240 @@
+/*
+ * Compute
+ */
+
+#include <vulkan>
+
+#include "gamekit/compute.h"
+#include "gamekit/device.h"
+#include "gamekit/utilities.h"
+
+#include <string>
+#include <stdexcept>
+#include <cassert>
+
+using namespace gamekit;
+
+ComputeMaterial ComputeMaterial::make() {
+
+    ComputeMaterial material;
+
+    material.create();
+
+    return material;
+
+}
+
+void ComputeMaterial::create() {
+    modified_ = true;
+}
+
+void ComputeMaterial::destroy() {
+    freeDescriptorSets();
+    freeComputePipeline();
+
+    buffers_.clear();
+    shader_ = nullptr;
+
+    numUniformBuffers_ = 0;
+    numStorageBuffers_ = 0;
+}
+
+const Shader* ComputeMaterial::setShader(const Shader& shader) {
+
+    if (shader.type() != ShaderType::ComputeShader) {
+        throw std::runtime_error("compute material requires a compute shader");
+    }
+
+    shader_ = &shader;
+    modified_ = true;
+
+    return &shader;
+}
+
+const Buffer* ComputeMaterial::addBuffer(Buffer& buffer) {
+
+    switch (buffer.bufferType()) {
+        case BufferType::UniformBuffer: numUniformBuffers_++; break;
+        case BufferType::ShaderStorageBuffer: numStorageBuffers_++; break;
+        default: throw std::runtime_error("unsupported buffer type for compute material");
+    }
+
+    buffers_.emplace_back(&buffer);
+    modified_ = true;
+
+    return &buffer;
+}
+
+void ComputeMaterial::invalidate(const Shader& shader) {
+    if (shader_ == &shader) {
+        modified_ = true;
+    }
+}
+
+void ComputeMaterial::createComputePipeline() {
+
+    auto device = Device::globalInstance();
+    assert(device);
+    assert(nullptr != shader_);
+
+    PipelineDescription description;
+    description.stages.push_back({ VK_SHADER_STAGE_COMPUTE_BIT, *shader_ });
+
+    for (auto buffer : buffers_) {
+        VkDescriptorSetLayoutBinding binding{};
+        binding.descriptorType = (buffer->bufferType() == BufferType::UniformBuffer) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        binding.binding = buffer->binding();
+        binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        binding.descriptorCount = 1;
+        binding.pImmutableSamplers = nullptr;
+
+        description.bindings.emplace_back(binding);
+    }
+
+    pipeline_ = device->pipelines().acquire(description);
+}
+
+void ComputeMaterial::freeComputePipeline() {
+    if (nullptr == pipeline_) return;
+    Device::globalInstance()->pipelines().release(pipeline_);
+    pipeline_ = nullptr;
+}
+
+void ComputeMaterial::createDescriptorSets() {
+
+    descriptorSets_.clear();
+
+    if (nullptr == pipeline_->descriptorSetLayout()) return;
+
+    auto device = Device::globalInstance();
+    auto numFrames = device->frameCount();
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    if (numUniformBuffers_ > 0) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (uint32_t) (numFrames * numUniformBuffers_) });
+    if (numStorageBuffers_ > 0) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, (uint32_t) (numFrames * numStorageBuffers_) });
+
+    descriptorPool_ = DescriptorPool::make(poolSizes, numFrames);
+
+    for (size_t frameIndex = 0; frameIndex < numFrames; frameIndex++) {
+        descriptorSets_.emplace_back(createDescriptorSet(frameIndex));
+    }
+}
+
+DescriptorSet ComputeMaterial::createDescriptorSet(size_t frameIndex) {
+
+    auto descriptorSet = DescriptorSet::make(pipeline_->descriptorSetLayout(), descriptorPool_);
+
+    auto device = Device::globalInstance();
+
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    bufferInfos.reserve(buffers_.size());
+    std::vector<VkWriteDescriptorSet> descriptorWrites;
+    descriptorWrites.reserve(buffers_.size());
+
+    for (auto buffer : buffers_) {
+
+        auto isUniform = (buffer->bufferType() == BufferType::UniformBuffer);
+
+        // per-frame buffer, or the shared gpu resident storage buffer
+        auto& bufferObject = isUniform ?
+            dynamic_cast<UniformBuffer*>(buffer)->allocFrameBuffer(frameIndex) :
+            dynamic_cast<ShaderStorageBuffer*>(buffer)->allocFrameBuffer(frameIndex);
+
+        auto& bufferInfo = bufferInfos.emplace_back();
+        bufferInfo.buffer = bufferObject;
+        bufferInfo.offset = 0;
+        bufferInfo.range = bufferObject.size();
+
+        auto& descriptorWrite = descriptorWrites.emplace_back();
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = descriptorSet;
+        descriptorWrite.dstBinding = buffer->binding();
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = isUniform ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo = &bufferInfo;
+    }
+
+    if (descriptorWrites.size() > 0) {
+        vkUpdateDescriptorSets(
+            device->handle(),
+            static_cast<uint32_t>(descriptorWrites.size()),
+            descriptorWrites.data(),
+            0, nullptr);
+    }
+
+    return descriptorSet;
+}
+
+void ComputeMaterial::freeDescriptorSets() {
+    descriptorPool_.destroy();
+    descriptorSets_.clear();
+}
+
+void ComputeMaterial::compile() {
+    update();
+}
+
+void ComputeMaterial::update() {
+    if (false == modified_) return;
+
+    freeDescriptorSets();
+    freeComputePipeline();
+
+    createComputePipeline();
+    createDescriptorSets();
+
+    modified_ = false;
+}
+
+void ComputeMaterial::dispatch() {
+
+    if (0 == groupCount_[0] || 0 == groupCount_[1] || 0 == groupCount_[2]) {
+        return;
+    }
+
+    update();
+
+    assert(nullptr != pipeline_);
+
+    auto device = Device::globalInstance();
+    const auto& frame = device->currentFrame();
+    const auto& commandBuffer = frame.commandBuffer;
+
+    GpuScope scope(device->profiler(), "compute");
+
+    // storage buffers are shared by all frames in flight: wait for vertex
+    // fetches and dispatches of earlier submissions and for pending uploads
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_->ptr());
+
+    if (!descriptorSets_.empty()) {
+        const auto& descriptorSet = descriptorSets_[frame.index];
+        vkCmdBindDescriptorSets(commandBuffer,
+                                VK_PIPELINE_BIND_POINT_COMPUTE,
+                                pipeline_->pipelineLayout(),
+                                0, 1, descriptorSet.ref_ptr(),
+                                0, nullptr);
+    }
+
+    vkCmdDispatch(commandBuffer, groupCount_[0], groupCount_[1], groupCount_[2]);
+
+    // results are consumed as vertex input or storage reads in the render pass
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
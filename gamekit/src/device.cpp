@@ -89,14 +89,48 @@ VkDevice Device::globalHandle() {
 void Device::createDevice(Window& window, bool enableErrorChecking) {
 
     enableErrorChecking_ = enableErrorChecking;
+    headless_ = false;
 
-    createInstance(window);
+    createInstance(window.getVulkanExtensions());
 
     Loader::instance()->registerInstance(instance_);
 
     createSurface(window);
     createPhysicalDevice();
     createLogicalDevice();
+    allocator_.create(physicalDevice_, device_);
+    pipelineCache_.create(physicalDevice_, device_, pipelineCacheFile_);
+    workers_.create();
+    createTextureTable();
+    createCommandPool();
+
+    visible_ = true;
+}
+
+void Device::createHeadlessDevice(int width, int height, bool enableErrorChecking) {
+
+    enableErrorChecking_ = enableErrorChecking;
+    headless_ = true;
+    headlessExtent_ = { (uint32_t) width, (uint32_t) height };
+
+    // no surface, no swap chain: frames are rendered into offscreen targets
+    requiredDeviceExtensions_.erase(
+        std::remove_if(requiredDeviceExtensions_.begin(), requiredDeviceExtensions_.end(), [](const char* name) {
+            return EXT_SWAPCHAIN == name;
+        }),
+        requiredDeviceExtensions_.end()
+    );
+
+    createInstance({});
+
+    Loader::instance()->registerInstance(instance_);
+
+    createPhysicalDevice();
+    createLogicalDevice();
+    allocator_.create(physicalDevice_, device_);
+    pipelineCache_.create(physicalDevice_, device_, pipelineCacheFile_);
+    workers_.create();
+    createTextureTable();
     createCommandPool();
 
     visible_ = true;
@@ -105,6 +139,14 @@ void Device::createDevice(Window& window, bool enableErrorChecking) {
 void Device::destroyDevice() {
     visible_ = false;
 
+    transfers_.destroy();
+    renderQueue_.destroy();
+    workers_.destroy();         // joins pending pipeline compiles
+    pipelines_.destroy();
+    textureTable_.destroy();
+    samplers_.destroy();
+    pipelineCache_.destroy();   // written back to disk
+    allocator_.destroy();
     destroyCommandPool();
     destroyPhysicalDevice();
     destroyLogicalDevice();
@@ -116,8 +158,12 @@ void Device::destroyDevice() {
 
 void Device::createRenderer() {
     assert(device_.notNull());
-    createSwapChain();
-    createImageViews();
+    if (headless_) {
+        createRenderTargets();
+    } else {
+        createSwapChain();
+        createImageViews();
+    }
     createDepthBuffer();
     createRenderPass();
     createFrameBuffers();
@@ -143,6 +189,7 @@ void Device::destroyRenderer(bool freePipelineResources) {
 
     destroyRenderPass();
     destroyDepthBuffer();
+    destroyRenderTargets();
     destroyImageViews();
     destroySwapChain();
 
@@ -151,6 +198,10 @@ void Device::destroyRenderer(bool freePipelineResources) {
 void Device::reinitRenderer() {
     assert(device_.notNull());
 
+    if (headless_) {
+        return; // offscreen targets never go out of date
+    }
+
     waitIdle();
 
     if (visible_) {
@@ -173,7 +224,7 @@ void Device::reinitRenderer() {
     visible_ = true;
 }
 
-void Device::createInstance(Window& window) {
+void Device::createInstance(std::vector<const char*> requiredInstanceExtensions) {
 
     VkInstanceCreateInfo instanceInfo = {};
     instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -187,8 +238,6 @@ void Device::createInstance(Window& window) {
     appInfo.apiVersion = VK_API_VERSION_1_2;
     instanceInfo.pApplicationInfo = &appInfo;
 
-    auto requiredInstanceExtensions = window.getVulkanExtensions();
-
     if constexpr (ENABLE_EXTENDED_DYNAMIC_STATE) {
         requiredInstanceExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
     }
@@ -279,8 +328,12 @@ void Device::createPhysicalDevice() {
         VkPhysicalDeviceProperties deviceProperties{};
         vkGetPhysicalDeviceProperties(device, &deviceProperties);
 
+        // software rasterizers (lavapipe) are accepted for headless rendering
+        bool isCpuDevice = (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU);
+
         if (deviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
-            deviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) {
+            deviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU &&
+            !(headless_ && isCpuDevice)) {
             // TODO: extend by rating and choosing best possible GPU
             continue;
         }
@@ -303,6 +356,34 @@ void Device::createPhysicalDevice() {
             continue;
         }
 
+        if (headless_) {
+            // graphics queue only, rendering into offscreen color targets
+            uint32_t queueFamilyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+
+            std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+            physicalDeviceInfo_.graphicsFamilyIndex = physicalDeviceInfo_.presentFamilyIndex = -1;
+
+            for (uint32_t i = 0; i < queueFamilyCount; i++) {
+                if (0 != (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                    physicalDeviceInfo_.graphicsFamilyIndex = physicalDeviceInfo_.presentFamilyIndex = (int) i;
+                    break;
+                }
+            }
+
+            if (-1 == physicalDeviceInfo_.graphicsFamilyIndex) {
+                continue;
+            }
+
+            physicalDeviceInfo_.surfaceFormat = { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+            physicalDeviceInfo_.mailBoxBodeSupport = false;
+
+            physicalDevice = device;
+            break;
+        }
+
         // check surface formats
         uint32_t formatCount = 0;
         vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface_, &formatCount, nullptr);
@@ -426,6 +507,7 @@ void Device::createLogicalDevice() {
     VkPhysicalDeviceFeatures2 deviceFeatures2{};
     VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicStateFeatures{};
     VkPhysicalDeviceExtendedDynamicState2FeaturesEXT dynamicState2Features{};
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
 
     //if constexpr (ENABLE_EXTENDED_DYNAMIC_STATE) {
 
@@ -436,17 +518,28 @@ void Device::createLogicalDevice() {
         dynamicStateFeatures.pNext = &dynamicState2Features;
 
         dynamicState2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
-        dynamicState2Features.pNext = nullptr;
+        dynamicState2Features.pNext = &descriptorIndexingFeatures;
+
+        // core in vulkan 1.2, formerly VK_EXT_descriptor_indexing
+        descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        descriptorIndexingFeatures.pNext = nullptr;
 
         vkGetPhysicalDeviceFeatures2(physicalDevice_, &deviceFeatures2);
         assert (VK_TRUE == dynamicStateFeatures.extendedDynamicState);
 
+        bindlessSupported_ = VK_TRUE == descriptorIndexingFeatures.runtimeDescriptorArray &&
+                             VK_TRUE == descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+                             VK_TRUE == descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+                             VK_TRUE == descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+                             VK_TRUE == descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+
         // enable extended device features
         createInfo.pEnabledFeatures = nullptr; // must be set to null
         createInfo.pNext = &deviceFeatures2;
         deviceFeatures2.pNext = &dynamicStateFeatures;
         dynamicStateFeatures.pNext = &dynamicState2Features;
-        dynamicState2Features.pNext = nullptr;
+        dynamicState2Features.pNext = &descriptorIndexingFeatures;
+        descriptorIndexingFeatures.pNext = nullptr;
 
     //}
 
@@ -472,6 +565,14 @@ void Device::destroyLogicalDevice() {
 
 void Device::getViewportExtent() {
 
+    if (headless_) {
+        metrics_.width = (int) headlessExtent_.width;
+        metrics_.height = (int) headlessExtent_.height;
+        metrics_.width_f = (float) metrics_.width;
+        metrics_.height_f = (float) metrics_.height;
+        return;
+    }
+
     VkSurfaceCapabilitiesKHR deviceSurfaceCapabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice_, surface_, &deviceSurfaceCapabilities);
 
@@ -567,6 +668,112 @@ void Device::createImageViews() {
     }
 }
 
+void Device::createRenderTargets() {
+
+    getViewportExtent();
+    swapChainInfo_.extent = headlessExtent_;
+    swapChainInfo_.format = physicalDeviceInfo_.surfaceFormat.format;
+
+    // one offscreen color target per frame in flight, used as a ring
+    swapChainInfo_.images.clear();
+    swapChainInfo_.imageViews.clear();
+    readbackBuffers_.clear();
+
+    for (size_t i = 0; i < frameCount(); i++) {
+        auto& image = swapChainInfo_.images.emplace_back(Image::make(
+            ImageType::RenderTarget,
+            (int) headlessExtent_.width,
+            (int) headlessExtent_.height,
+            swapChainInfo_.format));
+        swapChainInfo_.imageViews.emplace_back(ImageView::make(image));
+
+        if (readbackEnabled_) {
+            readbackBuffers_.emplace_back(BufferObject::make(
+                BufferType::StagingBuffer,
+                image.size(),
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory));
+        }
+    }
+
+    readbackFrame_ = -1;
+}
+
+void Device::destroyRenderTargets() {
+    if (device_.isNull() || !headless_) return;
+    readbackBuffers_.clear();
+    readbackFrame_ = -1;
+}
+
+void Device::recordReadback(const Frame& frame) {
+
+    const auto& image = swapChainInfo_.images[currentImageIndex_];
+    const auto& buffer = readbackBuffers_[currentImageIndex_];
+
+    // render pass leaves the target in transfer source layout
+    VkImageMemoryBarrier imageBarrier{};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = image.ptr();
+    imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    vkCmdPipelineBarrier(frame.commandBuffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         1, &imageBarrier);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { swapChainInfo_.extent.width, swapChainInfo_.extent.height, 1 };
+
+    vkCmdCopyImageToBuffer(frame.commandBuffer, image.ptr(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer.ptr(), 1, &region);
+
+    VkBufferMemoryBarrier bufferBarrier{};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = buffer.ptr();
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(frame.commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                         0,
+                         0, nullptr,
+                         1, &bufferBarrier,
+                         0, nullptr);
+}
+
+bool Device::readback(std::vector<uint8_t>& pixels) {
+
+    // only offscreen targets can be read back, pixels are tightly packed RGBA8
+    if (!headless_ || readbackFrame_ < 0 || readbackBuffers_.empty()) {
+        return false;
+    }
+
+    frames_[readbackFrame_].commandBuffersCompleted.wait();
+
+    const auto& buffer = readbackBuffers_[readbackFrame_];
+    auto data = static_cast<const uint8_t*>(buffer.map());
+    if (nullptr == data) {
+        return false;
+    }
+
+    pixels.assign(data, data + buffer.size());
+    buffer.unmap();
+
+    return true;
+}
+
 void Device::createRenderPass() {
 
     assert(device_.notNull());
@@ -581,13 +788,13 @@ void Device::createRenderPass() {
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = headless_ ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = swapChainInfo_.depthImage.format();
     depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.storeOp = parallelRecording_ ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -630,6 +837,24 @@ void Device::createRenderPass() {
     if (VK_SUCCESS != res) {
         throw std::runtime_error(Format::str("Failed to create render pass: err={}", (int) res));
     }
+
+    if (!parallelRecording_) return;
+
+    // compatible continuation, the render queue records into it from worker threads
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[0].initialLayout = colorAttachment.finalLayout;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = depthAttachment.finalLayout;
+
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+
+    res = vkCreateRenderPass(device_, &renderPassInfo, nullptr, renderPassContinue_.ref_ptr());
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create render pass: err={}", (int) res));
+    }
 }
 
 void Device::createDepthBuffer() {
@@ -697,9 +922,24 @@ void Device::createFrames() {
         frame.create(frameIndex++);
     }
 
+    if (gpuProfiling_) {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, queueFamilies.data());
+
+        auto timestampValidBits = queueFamilies[physicalDeviceInfo_.graphicsFamilyIndex].timestampValidBits;
+        profiler_.create(numFrames, timestampValidBits);
+    }
+
     for (auto material : materials_) {
         material->compile();
     }
+
+    for (auto computeMaterial : computeMaterials_) {
+        computeMaterial->compile();
+    }
 }
 
 void Device::addMaterial(Material& material) {
@@ -707,6 +947,54 @@ void Device::addMaterial(Material& material) {
     setMaterial(&material);
 }
 
+void Device::addComputeMaterial(ComputeMaterial& computeMaterial) {
+    computeMaterials_.emplace_back(&computeMaterial);
+}
+
+void Device::invalidate(const Shader& shader) {
+
+    for (auto material : materials_) {
+        material->invalidate(shader);
+    }
+
+    for (auto computeMaterial : computeMaterials_) {
+        computeMaterial->invalidate(shader);
+    }
+}
+
+void Device::invalidate(const Texture& texture) {
+
+    if (textureTable_.isValid()) {
+        textureTable_.refresh(texture);
+    }
+
+    for (auto material : materials_) {
+        material->invalidate(texture);
+    }
+}
+
+void Device::createTextureTable() {
+
+    if (!bindlessSupported_) return; // materials keep their per-texture bindings
+
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexingProperties;
+
+    vkGetPhysicalDeviceProperties2(physicalDevice_, &properties);
+
+    // combined image samplers count against both the sampler and the sampled image limits
+    auto capacity = std::min({ indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+                               indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                               indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+                               indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+    textureTable_.create(capacity);
+}
+
 void Device::createCommandPool() {
 
     assert(physicalDeviceInfo_.graphicsFamilyIndex >= 0);
@@ -748,6 +1036,7 @@ void Device::destroyCommandPool() {
 }
 
 void Device::destroyRenderPass() {
+    renderPassContinue_ = nullptr;
     renderPass_ = nullptr;
 }
 
@@ -757,6 +1046,8 @@ void Device::destroyFrames() {
 
     waitIdle();
 
+    profiler_.destroy();
+
     for (auto& frame : frames_) {
         frame.destroy();
     }
@@ -769,6 +1060,8 @@ void Device::freeGraphicsPipelineObjects() {
 
     waitIdle();
 
+    renderQueue_.clear();
+
     for (auto material : materials_) {
         material->destroy();
     }
@@ -776,6 +1069,12 @@ void Device::freeGraphicsPipelineObjects() {
     materials_.clear();
     material_ = nullptr;
 
+    for (auto computeMaterial : computeMaterials_) {
+        computeMaterial->destroy();
+    }
+
+    computeMaterials_.clear();
+
 }
 
 void Device::destroyFrameBuffers() {
@@ -799,12 +1098,14 @@ void Device::beginDraw() {
     // wait for previous frame
     frame.commandBuffersCompleted.wait();
 
-    uint32_t imageIndex;
-    res = vkAcquireNextImageKHR(device_, swapChainInfo_.handle, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
-    if (VK_ERROR_OUT_OF_DATE_KHR == res) {
-        reinitRenderer();
-    } else if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error(Format::str("Failed to acquire swap chain image: err={}", (int) res));
+    uint32_t imageIndex = currentFrame_;
+    if (!headless_) {
+        res = vkAcquireNextImageKHR(device_, swapChainInfo_.handle, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+        if (VK_ERROR_OUT_OF_DATE_KHR == res) {
+            reinitRenderer();
+        } else if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error(Format::str("Failed to acquire swap chain image: err={}", (int) res));
+        }
     }
 
     frame.commandBuffersCompleted.reset();
@@ -819,6 +1120,24 @@ void Device::beginDraw() {
         throw std::runtime_error(Format::str("Failed to begin recording command buffer: err={}", (int) res));
     }
 
+    // resolves the queries of this frame slot's previous submission
+    profiler_.beginFrame(frame.index, commandBuffer);
+
+    // texture slots released frames in flight ago become reusable
+    textureTable_.update();
+
+    // materials pick up pipelines compiled in the background
+    for (auto material : materials_) {
+        material->prepare();
+    }
+
+    // compute work is recorded outside of the render pass
+    for (auto computeMaterial : computeMaterials_) {
+        computeMaterial->dispatch();
+    }
+
+    renderPassScope_ = profiler_.beginScope("renderpass");
+
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass_;
@@ -834,9 +1153,8 @@ void Device::beginDraw() {
 
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-    if (nullptr != material_) {
-        material_->bind();
-    }
+    // false while the material's first pipeline is still compiling
+    materialBound_ = (nullptr != material_) && material_->bind();
 
     // dynamic state for viewport
     VkViewport viewport{};
@@ -863,8 +1181,43 @@ void Device::endDraw() {
 
     auto& frame = frames_[currentFrame_];
 
+    auto renderQueueScope = GpuProfiler::npos;
+
+    // deferred draws, sorted by state
+    if (parallelRecording_ && renderQueue_.size() >= 2 * RenderQueue::MIN_DRAWS_PER_THREAD) {
+
+        // a subpass is either inline or secondary, continue in a second pass for the worker recordings
+        vkCmdEndRenderPass(frame.commandBuffer);
+
+        // timestamps are not allowed inside a secondary contents subpass
+        renderQueueScope = profiler_.beginScope("renderqueue");
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPassContinue_;
+        renderPassInfo.framebuffer = frameBuffers_[currentImageIndex_];
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = swapChainInfo_.extent;
+
+        vkCmdBeginRenderPass(frame.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+        renderQueue_.flushParallel(renderPassContinue_, frameBuffers_[currentImageIndex_], swapChainInfo_.extent);
+
+    } else {
+        renderQueue_.flush();
+    }
+
     vkCmdEndRenderPass(frame.commandBuffer);
 
+    profiler_.endScope(renderQueueScope);
+
+    profiler_.endScope(renderPassScope_);
+    renderPassScope_ = GpuProfiler::npos;
+
+    if (headless_ && !readbackBuffers_.empty()) {
+        recordReadback(frame);
+    }
+
     res = frame.commandBuffer.end();
     if (VK_SUCCESS != res) {
         throw std::runtime_error(Format::str("Failed to record command buffer: err={}", (int) res));
@@ -875,7 +1228,7 @@ void Device::endDraw() {
 
     VkSemaphore waitSemaphores[] = {frame.imageAvailable};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = headless_ ? 0 : 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount = 1;
@@ -884,14 +1237,25 @@ void Device::endDraw() {
     submitInfo.pCommandBuffers = &commandBuffer;
 
     VkSemaphore signalSemaphores[] = {frame.renderFinished};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = headless_ ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
+    // pending uploads go ahead of the frame on the same queue
+    transfers_.submit();
+
     res = vkQueueSubmit(graphicsQueue_, 1, &submitInfo, frame.commandBuffersCompleted);
     if (VK_SUCCESS != res) {
         throw std::runtime_error(Format::str("Failed to submit draw command buffer: err={}", (int) res));
     }
 
+    if (headless_) {
+        // nothing to present, the target stays available for readback
+        if (!readbackBuffers_.empty()) readbackFrame_ = (int) currentFrame_;
+        currentFrame_ = (currentFrame_ + 1) % frames_.size();
+        currentImageIndex_ = 0;
+        return;
+    }
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
@@ -920,6 +1284,11 @@ const Frame& Device::currentFrame() const {
 
 bool Device::begin(Window& window) {
 
+    if (headless_) {
+        beginDraw();
+        return true;
+    }
+
     window.getState(windowState_);
 
     if (!isVisible()) {
@@ -943,47 +1312,38 @@ bool Device::end() {
 }
 
 VkCommandBuffer Device::beginCommand() {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool_;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    return commandBuffer;
+    return transfers_.begin();
 }
 
 void Device::endCommand(VkCommandBuffer commandBuffer) {
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue_);
+    // commands stay in the transfer batch, submitted with the next frame
+    // or explicitly by flushTransfers()
+    assert(transfers_.isRecording());
+}
 
-    vkFreeCommandBuffers(device_, commandPool_, 1, &commandBuffer);
+void Device::flushTransfers(bool wait) {
+    if (wait) {
+        transfers_.flush();
+    } else {
+        transfers_.submit();
+    }
 }
 
 void Device::drawIndexed(size_t count, size_t offset) {
+    if (!materialBound_) return;
     const auto& frame = currentFrame();
     const auto& commandBuffer = frame.commandBuffer;
+    material_->flushPushConstants(commandBuffer);
+    GpuScope scope(profiler_, "drawIndexed");
     vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(count), 1, static_cast<uint32_t>(offset), 0, 0);
 }
 
 void Device::draw(size_t count, size_t offset, size_t instances) {
+    if (!materialBound_) return;
     const auto& frame = currentFrame();
     const auto& commandBuffer = frame.commandBuffer;
+    material_->flushPushConstants(commandBuffer);
+    GpuScope scope(profiler_, "draw");
     vkCmdDraw(commandBuffer, static_cast<uint32_t>(count), static_cast<uint32_t>(instances), static_cast<uint32_t>(offset), 0);
 }
 
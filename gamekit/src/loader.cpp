@@ -54,11 +54,29 @@ void Loader::load() {
 
     //volkInitializeCustom(SDL_vkGetInstanceProcAddr);
 
+    headless_ = false;
+    loaded_ = true;
+}
+
+void Loader::loadHeadless() {
+
+    if (loaded_) return;
+
+    // no video subsystem available, resolve the vulkan loader directly
+    auto res = volkInitialize();
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("failed to load vulkan library: err={}", (int) res));
+    }
+
+    headless_ = true;
     loaded_ = true;
 }
 
 void Loader::unload() {
-    SDL_Vulkan_UnloadLibrary();
+    if (!loaded_) return;
+    if (!headless_) {
+        SDL_Vulkan_UnloadLibrary();
+    }
     loaded_ = false;
 }
 
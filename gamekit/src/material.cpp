@@ -11,6 +11,9 @@
 #include "gamekit/utilities.h"
 
 #include <string>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
 #include <stdexcept>
 #include <cassert>
 
@@ -27,10 +30,22 @@ Material Material::make() {
 }
 
 void Material::create() {
+    static uint32_t nextId = 1;
+    id_ = nextId++;
     modified_ = true;
 }
 
 void Material::destroy() {
+
+    if (pendingPipeline_.valid()) {
+        try {
+            Device::globalInstance()->pipelines().release(pendingPipeline_.get());
+        } catch (...) {
+            // compile error of a variant that never got used
+        }
+    }
+
+    releaseRetired(true);
     freeDescriptorSets();
     freeGraphicsPipeline();
 
@@ -38,26 +53,17 @@ void Material::destroy() {
     textures_.clear();
     shaders_.clear();
 
-    shaderStages_.clear();
     pushConstantRanges_.clear();
 
     numVertexBuffers_ = 0;
     numUniformBuffers_ = 0;
+    numStorageBuffers_ = 0;
 }
 
 const Shader* Material::addShader(const Shader& shader) {
 
     shaders_.emplace_back(&shader);
-
-    VkShaderStageFlagBits stage = (shader.type() == ShaderType::FragmentShader) ? VK_SHADER_STAGE_FRAGMENT_BIT : VK_SHADER_STAGE_VERTEX_BIT;
-
-    VkPipelineShaderStageCreateInfo shaderStageCreateInfo{};
-    shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    shaderStageCreateInfo.stage = stage;
-    shaderStageCreateInfo.module = shader;
-    shaderStageCreateInfo.pName = "main";
-
-    shaderStages_.emplace_back(shaderStageCreateInfo);
+    modified_ = true;
 
     return &shader;
 }
@@ -68,14 +74,19 @@ const Buffer* Material::addBuffer(Buffer& buffer) {
     switch (buffer.bufferType()) {
         case BufferType::VertexBuffer: numVertexBuffers_++; break;
         case BufferType::UniformBuffer: numUniformBuffers_++; break;
+        case BufferType::ShaderStorageBuffer: numStorageBuffers_++; break;
         default: break;
     }
 
+    modified_ = true;
+
     return &buffer;
 }
 
 const Texture* Material::addTexture(const Texture& texture, uint32_t binding) {
     textures_.emplace_back(TextureInfo{&texture, binding});
+    modified_ = true;
+
     return &texture;
 }
 
@@ -96,166 +107,66 @@ const PushConstantsBase* Material::addPushConstants(PushConstantsBase& pushConst
     range.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
 
     pushConstantRanges_.push_back(range);
+    modified_ = true;
 
     return &pushConstants;
 }
 
 void Material::updatePushConstants(const PushConstantsBase& pushConstants) {
 
-    const auto& frame = Device::globalInstance()->currentFrame();
+    // all ranges start at offset 0, the largest one covers the stored bytes
+    auto size = pushConstants.size();
+    if (pushConstantData_.size() < size) {
+        pushConstantData_.resize(size);
+    }
 
-    const auto& commandBuffer = frame.commandBuffer;
-    assert(nullptr != commandBuffer.ptr());
+    std::memcpy(pushConstantData_.data(), pushConstants.raw_ptr(), size);
+    pushConstantsPending_ = true;
+}
 
-    vkCmdPushConstants(commandBuffer.ptr(),
-                       pipelineLayout_,
+void Material::recordPushConstants(VkCommandBuffer commandBuffer) const {
+
+    if (nullptr == pipeline_ || pushConstantData_.empty()) return;
+
+    vkCmdPushConstants(commandBuffer,
+                       pipeline_->pipelineLayout(),
                        VK_SHADER_STAGE_ALL_GRAPHICS,
                        0,
-                       static_cast<uint32_t>(pushConstants.size()),
-                       pushConstants.raw_ptr());
-
+                       static_cast<uint32_t>(pushConstantData_.size()),
+                       pushConstantData_.data());
+}
 
+void Material::flushPushConstants(VkCommandBuffer commandBuffer) {
+    if (!pushConstantsPending_) return;
+    recordPushConstants(commandBuffer);
+    pushConstantsPending_ = false;
 }
 
-void Material::createGraphicsPipeline() {
+PipelineDescription Material::createPipelineDescription() const {
 
     auto device = Device::globalInstance();
     assert(device);
 
-    VkResult res = VK_SUCCESS;
-
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = nullptr; // ignored because of dynamic state
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = nullptr;  // ignored because of dynamic state
-
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-    auto vertexBindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &vertexBindingDescription;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = backfaceCulling_ ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
-    rasterizer.frontFace = fontfaceClockWise_ ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-    rasterizer.depthBiasClamp = 0.0f; // Optional
-    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f; // Optional
-    multisampling.pSampleMask = nullptr; // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = depthTesting_ ? VK_TRUE : VK_FALSE;
-    depthStencil.depthWriteEnable = depthWriting_ ? VK_TRUE : VK_FALSE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.stencilTestEnable = VK_FALSE;
-
-    auto srcBlendFactor = VK_BLEND_FACTOR_ONE;
-    auto dstBlendFactor = VK_BLEND_FACTOR_ONE;
-
-    switch (blendMode_) {
-        case BlendMode::Normal: {
-            srcBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-            dstBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-            break;
-        }
-        case BlendMode::Additive: {
-            srcBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-            dstBlendFactor = VK_BLEND_FACTOR_ONE;
-            break;
-        }
-        case BlendMode::Multiply: {
-            srcBlendFactor = VK_BLEND_FACTOR_DST_COLOR;
-            dstBlendFactor = VK_BLEND_FACTOR_ZERO;
-            break;
-        }
-        default: {
-            break;
-        }
-    }
+    PipelineDescription description;
 
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = srcBlendFactor;
-    colorBlendAttachment.dstColorBlendFactor = dstBlendFactor;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f; // Optional
-    colorBlending.blendConstants[1] = 0.0f; // Optional
-    colorBlending.blendConstants[2] = 0.0f; // Optional
-    colorBlending.blendConstants[3] = 0.0f; // Optional
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // Dynamic state changes at draw time
-    ///////////////////////////////////////////////////////////////////////////////
-
-    std::vector<VkDynamicState> dynamicStates = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR,
-        VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
-        VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE
-    };
-
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-    dynamicState.pDynamicStates = dynamicStates.data();
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // Pipeline Layout
-    ///////////////////////////////////////////////////////////////////////////////
-
-    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    for (auto shader : shaders_) {
+        VkShaderStageFlagBits stage = (shader->type() == ShaderType::FragmentShader) ? VK_SHADER_STAGE_FRAGMENT_BIT : VK_SHADER_STAGE_VERTEX_BIT;
+        description.stages.push_back({ stage, *shader });
+    }
 
     // Buffer bindings
     for (auto buffer : buffers_) {
-        if (buffer->bufferType() != BufferType::UniformBuffer) continue;
+        auto bufferType = buffer->bufferType();
+        if (bufferType != BufferType::UniformBuffer && bufferType != BufferType::ShaderStorageBuffer) continue;
 
         VkDescriptorSetLayoutBinding binding{};
-        binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        binding.descriptorType = (bufferType == BufferType::UniformBuffer) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         binding.binding = buffer->binding();
         binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
         binding.descriptorCount = 1;
         binding.pImmutableSamplers = nullptr;
 
-        bindings.emplace_back(binding);
+        description.bindings.emplace_back(binding);
     }
 
     // Texture bindings
@@ -267,75 +178,39 @@ void Material::createGraphicsPipeline() {
         binding.descriptorCount = 1;
         binding.pImmutableSamplers = nullptr;
 
-        bindings.emplace_back(binding);
+        description.bindings.emplace_back(binding);
     }
 
-    // Create descriptor set layout
-    if (bindings.size() > 0) {
-        VkDescriptorSetLayoutCreateInfo layoutInfo{};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-        layoutInfo.pBindings = bindings.data();
+    description.pushConstantRanges = pushConstantRanges_;
 
-        res = vkCreateDescriptorSetLayout(device->handle(), &layoutInfo, nullptr, descriptorSetLayout_.ref_ptr());
-        if (VK_SUCCESS != res) {
-            throw std::runtime_error(Format::str("Failed to create descriptor set layout: err={}", (int) res));
+    if (bindless_) {
+        auto& textureTable = device->textureTable();
+        if (!textureTable.isValid()) {
+            throw std::runtime_error("bindless textures are not supported by the device");
         }
+        description.textureTableLayout = textureTable.layout();
     }
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-    if (nullptr != descriptorSetLayout_) {
-        pipelineLayoutInfo.setLayoutCount = 1;
-        pipelineLayoutInfo.pSetLayouts = descriptorSetLayout_.ref_ptr();
-    }
+    description.vertexLayout = vertexLayout_;
+    description.blendMode = blendMode_;
+    description.backfaceCulling = backfaceCulling_;
+    description.frontFaceClockwise = fontfaceClockWise_;
+    description.depthTesting = depthTesting_;
+    description.depthWriting = depthWriting_;
+    description.renderPass = device->renderPass();
 
-    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges_.size());
-    pipelineLayoutInfo.pPushConstantRanges = nullptr;
-    if (pushConstantRanges_.size() > 0) {
-        pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges_.data();
-    }
-
-    res = vkCreatePipelineLayout(device->handle(), &pipelineLayoutInfo, nullptr, pipelineLayout_.ref_ptr());
-    if (VK_SUCCESS != res) {
-        throw std::runtime_error(Format::str("Failed to create pipeline layout: err={}", (int) res));
-    }
-
-    ///////////////////////////////////////////////////////////////////////////////
-    // Pipeline
-    ///////////////////////////////////////////////////////////////////////////////
-
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = (uint32_t) shaderStages_.size();
-    pipelineInfo.pStages = shaderStages_.data();
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = &depthStencil;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = pipelineLayout_;
-    pipelineInfo.renderPass = device->renderPass();
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1; // Optional
-
-    res = vkCreateGraphicsPipelines(device->handle(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline_.ref_ptr());
-    if (VK_SUCCESS != res) {
-        throw std::runtime_error(Format::str("Failed to create graphics pipeline: err={}", (int) res));
-    }
+    return description;
+}
 
+void Material::createGraphicsPipeline() {
+    // materials with equal state share one pipeline and layout
+    pipeline_ = Device::globalInstance()->pipelines().acquire(createPipelineDescription());
 }
 
 void Material::freeGraphicsPipeline() {
-    if (nullptr == graphicsPipeline_) return;
-    graphicsPipeline_ = nullptr;
-    pipelineLayout_ = nullptr;
-    descriptorSetLayout_ = nullptr;
+    if (nullptr == pipeline_) return;
+    Device::globalInstance()->pipelines().release(pipeline_);
+    pipeline_ = nullptr;
 }
 
 void Material::createDescriptorSets() {
@@ -344,40 +219,47 @@ void Material::createDescriptorSets() {
 
     auto numFrames = device->frameCount();
     auto numTextures = textures_.size();
-    auto numDescriptors = numFrames * (numUniformBuffers_ + numTextures);
 
-    descriptorPool_ = DescriptorPool::make(numDescriptors);
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    if (numUniformBuffers_ > 0) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (uint32_t) (numFrames * numUniformBuffers_) });
+    if (numStorageBuffers_ > 0) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, (uint32_t) (numFrames * numStorageBuffers_) });
+    if (numTextures > 0) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, (uint32_t) (numFrames * numTextures) });
+    if (poolSizes.empty()) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (uint32_t) numFrames });
+
+    descriptorPool_ = DescriptorPool::make(poolSizes, numFrames);
 
     descriptorSets_.clear();
 
     for (size_t frameIndex = 0; frameIndex < numFrames; frameIndex++) {
-        descriptorSets_.emplace_back(createDescriptorSet());
+        descriptorSets_.emplace_back(createDescriptorSet(frameIndex));
     }
 
 }
 
-DescriptorSet Material::createDescriptorSet() {
+DescriptorSet Material::createDescriptorSet(size_t frameIndex) {
 
-    auto descriptorSet = DescriptorSet::make(descriptorSetLayout_, descriptorPool_);
+    auto descriptorSet = DescriptorSet::make(pipeline_->descriptorSetLayout(), descriptorPool_);
 
     auto device = Device::globalInstance();
     auto numTextures = textures_.size();
 
     std::vector<VkDescriptorBufferInfo> bufferInfos;
-    bufferInfos.reserve(numUniformBuffers_);
+    bufferInfos.reserve(numUniformBuffers_ + numStorageBuffers_);
     std::vector<VkDescriptorImageInfo> imageInfos;
     imageInfos.reserve(numTextures);
     std::vector<VkWriteDescriptorSet> descriptorWrites;
-    descriptorWrites.reserve(numUniformBuffers_ + numTextures);
+    descriptorWrites.reserve(numUniformBuffers_ + numStorageBuffers_ + numTextures);
 
     // shader buffers
     for (auto buffer : buffers_) {
 
-        if (buffer->bufferType() != BufferType::UniformBuffer) continue;
-        auto uniformBuffer = dynamic_cast<UniformBuffer*>(buffer);
+        auto bufferType = buffer->bufferType();
+        if (bufferType != BufferType::UniformBuffer && bufferType != BufferType::ShaderStorageBuffer) continue;
 
-        // allocate per-frame buffer
-        auto& bufferObject = uniformBuffer->allocFrameBuffer();
+        // per-frame buffer, or the shared gpu resident storage buffer
+        auto& bufferObject = (bufferType == BufferType::UniformBuffer) ?
+            dynamic_cast<UniformBuffer*>(buffer)->allocFrameBuffer(frameIndex) :
+            dynamic_cast<ShaderStorageBuffer*>(buffer)->allocFrameBuffer(frameIndex);
 
         auto& bufferInfo = bufferInfos.emplace_back();
         bufferInfo.buffer = bufferObject;
@@ -389,7 +271,7 @@ DescriptorSet Material::createDescriptorSet() {
         descriptorWrite.dstSet = descriptorSet;
         descriptorWrite.dstBinding = buffer->binding();
         descriptorWrite.dstArrayElement = 0;
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrite.descriptorType = (bufferType == BufferType::UniformBuffer) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         descriptorWrite.descriptorCount = 1;
         descriptorWrite.pBufferInfo = &bufferInfo;
     }
@@ -431,10 +313,12 @@ void Material::freeDescriptorSets() {
 }
 
 void Material::compile() {
-    update();
-}
 
-void Material::update() {
+    if (pendingPipeline_.valid()) {
+        pendingPipeline_.wait();
+        poll();
+    }
+
     if (false == modified_) return;
 
     freeDescriptorSets();
@@ -446,16 +330,124 @@ void Material::update() {
     modified_ = false;
 }
 
-void Material::bind() {
+void Material::update() {
+
+    poll();
+
+    // one compile in flight at a time, later changes are picked up when it lands
+    if (false == modified_ || pendingPipeline_.valid()) return;
+
+    modified_ = false;
+
+    auto device = Device::globalInstance();
+    auto& registry = device->pipelines();
+
+    pendingPipeline_ = device->workers().submit([&registry, description = createPipelineDescription()]() {
+        return registry.acquire(description);
+    });
+}
+
+void Material::poll() {
+
+    if (!pendingPipeline_.valid()) return;
+    if (pendingPipeline_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+    auto pipeline = pendingPipeline_.get(); // rethrows compile errors
+
+    retire();
+
+    pipeline_ = pipeline;
+    createDescriptorSets();
+}
+
+void Material::retire() {
+
+    if (nullptr == pipeline_) return;
+
+    auto device = Device::globalInstance();
+
+    // command buffers of the frames in flight still reference the old variant
+    RetiredPipeline retired;
+    retired.pipeline = pipeline_;
+    retired.descriptorPool = std::move(descriptorPool_);
+    retired.descriptorSets = std::move(descriptorSets_);
+    retired.framesLeft = device->frameCount();
+
+    retired_.emplace_back(std::move(retired));
+
+    pipeline_ = nullptr;
+    descriptorSets_.clear();
+}
+
+void Material::releaseRetired(bool all) {
+
+    if (retired_.empty()) return;
+
+    auto& registry = Device::globalInstance()->pipelines();
+
+    for (auto it = retired_.begin(); it != retired_.end();) {
+        if (all || 0 == --it->framesLeft) {
+            registry.release(it->pipeline);
+            it = retired_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Material::invalidate(const Shader& shader) {
+
+    if (std::find(shaders_.begin(), shaders_.end(), &shader) == shaders_.end()) return;
+
+    // a compile in flight still reads the replaced module
+    if (pendingPipeline_.valid()) {
+        pendingPipeline_.wait();
+        poll();
+    }
+
+    modified_ = true;
+}
+
+void Material::invalidate(const Texture& texture) {
+
+    auto used = std::any_of(textures_.begin(), textures_.end(), [&texture](const TextureInfo& textureInfo) {
+        return textureInfo.texture == &texture;
+    });
+
+    if (!used) return;
+
+    if (pendingPipeline_.valid()) {
+        pendingPipeline_.wait();
+        poll();
+    }
+
+    // the pipeline stays, only the image views in the descriptor sets changed
+    if (nullptr != pipeline_) {
+        freeDescriptorSets();
+        createDescriptorSets();
+    }
+}
+
+bool Material::prepare() {
 
+    releaseRetired();
     update();
 
-    assert(nullptr != graphicsPipeline_);
+    return nullptr != pipeline_;
+}
 
-    const auto& frame = Device::globalInstance()->currentFrame();
+bool Material::bind() {
+
+    // nothing compiled yet, the caller skips its draws
+    if (nullptr == pipeline_) return false;
+
+    auto device = Device::globalInstance();
+    const auto& frame = device->currentFrame();
     const auto& commandBuffer = frame.commandBuffer;
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+    GpuScope scope(device->profiler(), "material");
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_->ptr());
 
     setDynamicStates();
 
@@ -463,16 +455,30 @@ void Material::bind() {
 
     vkCmdBindDescriptorSets(commandBuffer,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipelineLayout_,
+                            pipeline_->pipelineLayout(),
                             0, 1, descriptorSet.ref_ptr(),
                             0, nullptr);
+
+    if (pipeline_->isBindless()) {
+        vkCmdBindDescriptorSets(commandBuffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipeline_->pipelineLayout(),
+                                TextureTable::SET, 1, device->textureTable().descriptorSet().ref_ptr(),
+                                0, nullptr);
+    }
+
+    recordPushConstants(commandBuffer);
+    pushConstantsPending_ = false;
+
+    return true;
 }
 
 void Material::setDynamicStates() {
-
     const auto& frame = Device::globalInstance()->currentFrame();
-    const auto& commandBuffer = frame.commandBuffer;
+    setDynamicStates(frame.commandBuffer);
+}
 
+void Material::setDynamicStates(VkCommandBuffer commandBuffer) const {
     vkCmdSetDepthTestEnableEXT(commandBuffer, depthTesting_ ? VK_TRUE : VK_FALSE);
     vkCmdSetDepthWriteEnableEXT(commandBuffer, depthWriting_ ? VK_TRUE : VK_FALSE);
 }
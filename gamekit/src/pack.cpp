@@ -0,0 +1,257 @@
+/*
+ * Pack
+ */
+
+#include "gamekit/pack.h"
+#include "gamekit/utilities.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace gamekit;
+
+static const char PACK_MAGIC[8] = { 'G', 'K', 'P', 'A', 'C', 'K', '\0', '\0' };
+static const uint32_t MAX_RESOURCE_TYPE = static_cast<uint32_t>(ResourceType::CompressedBitmap);
+
+///////////////////////////////////////////////////////////////////////////////
+// Mapped File
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        file_ = std::exchange(other.file_, nullptr);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+    }
+    return *this;
+}
+
+MappedFile MappedFile::open(const std::string& filename) {
+
+    MappedFile object;
+
+#ifdef _WIN32
+    auto file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file) {
+        throw std::runtime_error(Format::str("failed to open file: ", filename.c_str()));
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || 0 == fileSize.QuadPart) {
+        CloseHandle(file);
+        throw std::runtime_error(Format::str("failed to map empty file: ", filename.c_str()));
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    auto data = (nullptr != mapping) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (nullptr == data) {
+        if (nullptr != mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error(Format::str("failed to map file: ", filename.c_str()));
+    }
+
+    object.file_ = file;
+    object.mapping_ = mapping;
+    object.size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    auto fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(Format::str("failed to open file: ", filename.c_str()));
+    }
+
+    struct stat fileStat{};
+    if (0 != fstat(fd, &fileStat) || 0 == fileStat.st_size) {
+        ::close(fd);
+        throw std::runtime_error(Format::str("failed to map empty file: ", filename.c_str()));
+    }
+
+    auto data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file referenced
+
+    if (MAP_FAILED == data) {
+        throw std::runtime_error(Format::str("failed to map file: ", filename.c_str()));
+    }
+
+    object.size_ = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    object.data_ = static_cast<const uint8_t*>(data);
+
+    return object;
+}
+
+void MappedFile::close() {
+
+    if (nullptr == data_) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+#else
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+    file_ = nullptr;
+    mapping_ = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Resource Pack
+///////////////////////////////////////////////////////////////////////////////
+
+// overflow safe, offset and length are untrusted
+static bool isInRange(uint64_t offset, uint64_t length, uint64_t size) {
+    return offset <= size && size - offset >= length;
+}
+
+ResourcePack ResourcePack::open(const std::string& filename, const std::vector<std::string>& searchPaths) {
+
+    namespace fs = std::filesystem;
+
+    fs::path path(filename);
+
+    if (path.is_relative()) {
+        std::vector<fs::path> candidates;
+        candidates.emplace_back(fs::path(Environment::getBasePath()) / path);
+        for (const auto& searchPath : searchPaths) {
+            candidates.emplace_back(fs::path(searchPath) / path);
+        }
+
+        for (const auto& candidate : candidates) {
+            std::error_code ec;
+            if (fs::is_regular_file(candidate, ec)) {
+                path = candidate;
+                break;
+            }
+        }
+    }
+
+    ResourcePack object;
+    object.create(MappedFile::open(path.string()));
+
+    return object;
+}
+
+void ResourcePack::create(MappedFile&& file) {
+
+    destroy();
+
+    auto data = file.data();
+    auto size = file.size();
+
+    Header header{};
+    if (size < sizeof(header)) {
+        throw std::runtime_error("invalid resource pack");
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+
+    if (0 != std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) || VERSION != header.version) {
+        throw std::runtime_error("invalid resource pack");
+    }
+
+    // offsets are checked against the file, the entries are used in place.
+    // the counts are 32 bit, their byte sizes cannot overflow 64 bits
+    auto slotCount = static_cast<uint64_t>(header.slotCount);
+    auto entryCount = static_cast<uint64_t>(header.entryCount);
+    if (header.entriesOffset % alignof(Entry) != 0 ||
+        header.slotsOffset % alignof(uint32_t) != 0 ||
+        !isInRange(header.entriesOffset, entryCount * sizeof(Entry), size) ||
+        !isInRange(header.slotsOffset, slotCount * sizeof(uint32_t), size) ||
+        header.namesOffset > size ||
+        0 == header.slotCount || 0 != (header.slotCount & (header.slotCount - 1)) ||
+        slotCount < 2 * entryCount) {
+        throw std::runtime_error("invalid resource pack");
+    }
+
+    entries_ = reinterpret_cast<const Entry*>(data + header.entriesOffset);
+    slots_ = reinterpret_cast<const uint32_t*>(data + header.slotsOffset);
+    slotCount_ = header.slotCount;
+
+    auto names = reinterpret_cast<const char*>(data + header.namesOffset);
+    auto namesSize = size - header.namesOffset;
+
+    descriptors_.reserve(header.entryCount);
+
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        const auto& entry = entries_[i];
+
+        if (!isInRange(entry.offset, entry.size, size) ||
+            !isInRange(entry.nameOffset, (uint64_t) entry.nameSize + 1, namesSize) ||
+            entry.type > MAX_RESOURCE_TYPE) {
+            throw std::runtime_error("invalid resource pack");
+        }
+
+        auto& descriptor = descriptors_.emplace_back();
+        descriptor.name.assign(names + entry.nameOffset, entry.nameSize);
+        descriptor.data = data + entry.offset;
+        descriptor.dataSize = static_cast<size_t>(entry.size);
+        descriptor.type = static_cast<ResourceType>(entry.type);
+    }
+
+    // probing stops at an empty slot, a table without one is rejected
+    uint32_t emptySlots = 0;
+    for (uint32_t i = 0; i < slotCount_; i++) {
+        if (slots_[i] > header.entryCount) {
+            throw std::runtime_error("invalid resource pack");
+        }
+        if (0 == slots_[i]) emptySlots++;
+    }
+
+    if (0 == emptySlots) {
+        throw std::runtime_error("invalid resource pack");
+    }
+
+    file_ = std::move(file);
+}
+
+void ResourcePack::destroy() {
+    descriptors_.clear();
+    entries_ = nullptr;
+    slots_ = nullptr;
+    slotCount_ = 0;
+    file_.close();
+}
+
+const ResourceDescriptor* ResourcePack::find(std::string_view name) const {
+
+    if (0 == slotCount_) return nullptr;
+
+    auto value = makeResourceId(name);
+    auto mask = slotCount_ - 1;
+    auto slot = static_cast<uint32_t>(value) & mask;
+
+    // at most half full, probing ends at an empty slot
+    for (uint32_t probe = 0; probe < slotCount_; probe++, slot = (slot + 1) & mask) {
+        auto index = slots_[slot];
+        if (0 == index) return nullptr;
+
+        const auto& entry = entries_[index - 1];
+        if (entry.hash == value && descriptors_[index - 1].name == name) {
+            return &descriptors_[index - 1];
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,264 @@
+/*
+ * Particles
+ */
+
+#include "gamekit/particles.h"
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <execution>
+
+using namespace gamekit;
+
+static const glm::vec4 DEFAULT_TEXTURE_COORDS { 0.0f, 0.0f, 1.0f, 1.0f };
+
+static inline uint32_t nextRandom(uint32_t& state) {
+    // xorshift32, state must never be zero
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static inline float randomFloat(uint32_t& state, float rangeMin, float rangeMax) {
+    auto value = (float) (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+    return rangeMin + (rangeMax - rangeMin) * value;
+}
+
+static glm::vec4 hsvToRgb(float h, float s, float v) {
+
+    if (h >= 360.0f) h = 0.0f; else h /= 60.0f;
+    float fract = h - std::floor(h);
+    float p = v * (1.0f - s);
+    float q = v * (1.0f - s * fract);
+    float t = v * (1.0f - s * (1.0f - fract));
+
+    switch ((int) h) {
+        case 0: return glm::vec4(v, t, p, 1.0f);
+        case 1: return glm::vec4(q, v, p, 1.0f);
+        case 2: return glm::vec4(p, v, t, 1.0f);
+        case 3: return glm::vec4(p, q, v, 1.0f);
+        case 4: return glm::vec4(t, p, v, 1.0f);
+        case 5: return glm::vec4(v, p, q, 1.0f);
+        default: return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+template <typename Chunks, typename Function>
+static void forEachChunk(Chunks& chunks, bool parallel, Function&& function) {
+    if (parallel && chunks.size() > 1) {
+        std::for_each(std::execution::par, chunks.begin(), chunks.end(), function);
+    } else {
+        std::for_each(chunks.begin(), chunks.end(), function);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Particle System
+///////////////////////////////////////////////////////////////////////////////
+
+ParticleSystem ParticleSystem::make(size_t capacity, const glm::vec4& bounds, uint32_t seed) {
+    ParticleSystem particleSystem;
+    particleSystem.create(capacity, bounds, seed);
+    return particleSystem;
+}
+
+void ParticleSystem::create(size_t capacity, const glm::vec4& bounds, uint32_t seed) {
+
+    assert(capacity > 0);
+
+    count_ = capacity;
+
+    positionX_.assign(count_, bounds.x);
+    positionY_.assign(count_, bounds.y);
+    previousX_.assign(count_, bounds.x);
+    previousY_.assign(count_, bounds.y);
+    velocityX_.assign(count_, 0.0f);
+    velocityY_.assign(count_, 0.0f);
+    targetX_.resize(count_);
+    targetY_.resize(count_);
+    timeToLive_.resize(count_);
+    color_.resize(count_);
+    texmask_.resize(count_);
+    expired_.assign(count_, 0);
+
+    // fixed ranges, each worker owns its chunk and random state
+    chunks_.clear();
+    for (size_t begin = 0; begin < count_; begin += CHUNK_SIZE) {
+        auto& chunk = chunks_.emplace_back();
+        chunk.begin = begin;
+        chunk.end = std::min(begin + CHUNK_SIZE, count_);
+        chunk.random = seed ^ ((uint32_t) chunks_.size() * 0x85ebca6bu);
+        if (0 == chunk.random) chunk.random = 0x1;
+    }
+
+    for (auto& chunk : chunks_) {
+        for (auto i = chunk.begin; i < chunk.end; i++) {
+            respawn(i, chunk.random, bounds, true);
+        }
+    }
+}
+
+void ParticleSystem::update(float deltaTime, const glm::vec4& bounds) {
+    forEachChunk(chunks_, parallel_, [&](Chunk& chunk) {
+        updateChunk(chunk, deltaTime, bounds, nullptr, 0);
+    });
+}
+
+void ParticleSystem::update(float deltaTime, const glm::vec4& bounds, QuadInstanceBatch& batch) {
+    // update and write while the chunk is still in cache
+    forEachChunk(chunks_, parallel_, [&](Chunk& chunk) {
+        size_t outputCount = 0;
+        auto output = batch.concurrentAppend(chunk.end - chunk.begin, outputCount);
+        updateChunk(chunk, deltaTime, bounds, output, outputCount);
+    });
+}
+
+void ParticleSystem::write(QuadInstanceBatch& batch, float interpolation) const {
+    forEachChunk(chunks_, parallel_, [&](const Chunk& chunk) {
+        size_t outputCount = 0;
+        auto output = batch.concurrentAppend(chunk.end - chunk.begin, outputCount);
+        if (nullptr != output) {
+            writeChunk(chunk, output, outputCount, interpolation);
+        }
+    });
+}
+
+void ParticleSystem::write(QuadBatch& batch, float interpolation) const {
+
+    const auto& size = params_.size;
+    const auto& uv = DEFAULT_TEXTURE_COORDS;
+    const auto blend = 1.0f - interpolation;
+
+    forEachChunk(chunks_, parallel_, [&](const Chunk& chunk) {
+        for (auto i = chunk.begin; i < chunk.end; i++) {
+            auto color = color_[i];
+            auto x = positionX_[i] + (previousX_[i] - positionX_[i]) * blend;
+            auto y = positionY_[i] + (previousY_[i] - positionY_[i]) * blend;
+            batch.concurrentPush(x, y, size.x, size.y,
+                                 (float) (color & 0xff) / 255.0f,
+                                 (float) ((color >> 8) & 0xff) / 255.0f,
+                                 (float) ((color >> 16) & 0xff) / 255.0f,
+                                 (float) ((color >> 24) & 0xff) / 255.0f,
+                                 uv.x, uv.y, uv.z, uv.w,
+                                 texmask_[i], 0x0);
+        }
+    });
+}
+
+void ParticleSystem::updateChunk(Chunk& chunk, float deltaTime, const glm::vec4& bounds, QuadInstance* output, size_t outputCount) {
+
+    auto px = positionX_.data();
+    auto py = positionY_.data();
+    auto ox = previousX_.data();
+    auto oy = previousY_.data();
+    auto vx = velocityX_.data();
+    auto vy = velocityY_.data();
+    auto tx = targetX_.data();
+    auto ty = targetY_.data();
+    auto ttl = timeToLive_.data();
+    auto expired = expired_.data();
+
+    const auto minX = bounds.x;
+    const auto minY = bounds.y;
+    const auto maxX = bounds.z - params_.size.x;
+    const auto maxY = bounds.w - params_.size.y;
+
+    const auto steering = params_.steering * deltaTime;
+    const auto gravity = params_.gravity * deltaTime;
+    const auto step = params_.speed * deltaTime;
+    const auto bounce = params_.bounce;
+    const auto respawnDistance = params_.respawnDistance * params_.respawnDistance;
+
+    // motion kernel, selects instead of branches so the loop vectorizes.
+    // expired particles keep their state and are respawned afterwards.
+
+    for (auto i = chunk.begin; i < chunk.end; i++) {
+
+        ox[i] = px[i];
+        oy[i] = py[i];
+
+        auto dx = tx[i] - px[i];
+        auto dy = ty[i] - py[i];
+        auto distance = dx * dx + dy * dy;
+        auto invDistance = distance > 0.0f ? 1.0f / std::sqrt(distance) : 0.0f;
+
+        auto dead = ttl[i] <= 0.0f || distance < respawnDistance;
+
+        auto x = vx[i] + dx * invDistance * steering;
+        auto y = vy[i] + dy * invDistance * steering + gravity;
+        auto speed = x * x + y * y;
+        auto invSpeed = speed > 0.0f ? 1.0f / std::sqrt(speed) : 1.0f;
+        auto velX = x * invSpeed;
+        auto velY = y * invSpeed;
+
+        auto posX = px[i] + velX * step;
+        auto posY = py[i] + velY * step;
+
+        auto hitMaxY = posY >= maxY;
+        auto hitMinY = !hitMaxY && posY <= minY;
+        velY = hitMaxY ? -std::abs(velY * bounce) : (hitMinY ? std::abs(velY) : velY);
+        posY = hitMaxY ? maxY : (hitMinY ? minY : posY);
+
+        auto hitMaxX = posX >= maxX;
+        auto hitMinX = !hitMaxX && posX <= minX;
+        velX = hitMaxX ? -std::abs(velX) : (hitMinX ? std::abs(velX) : velX);
+        posX = hitMaxX ? maxX : (hitMinX ? minX : posX);
+
+        px[i] = dead ? px[i] : posX;
+        py[i] = dead ? py[i] : posY;
+        vx[i] = dead ? vx[i] : velX;
+        vy[i] = dead ? vy[i] : velY;
+        ttl[i] = dead ? ttl[i] : ttl[i] - deltaTime;
+        expired[i] = dead ? 1 : 0;
+    }
+
+    for (auto i = chunk.begin; i < chunk.end; i++) {
+        if (0 != expired[i]) {
+            respawn(i, chunk.random, bounds, false);
+        }
+    }
+
+    if (nullptr != output) {
+        writeChunk(chunk, output, outputCount);
+    }
+}
+
+void ParticleSystem::writeChunk(const Chunk& chunk, QuadInstance* output, size_t outputCount, float interpolation) const {
+
+    const glm::vec2 size = params_.size;
+
+    // measured from the current position, exact for the default of 1
+    const auto blend = 1.0f - interpolation;
+
+    // a batch near its capacity takes only the leading part of the chunk
+    auto end = std::min(chunk.end, chunk.begin + outputCount);
+
+    auto instance = output;
+    for (auto i = chunk.begin; i < end; i++) {
+        auto x = positionX_[i] + (previousX_[i] - positionX_[i]) * blend;
+        auto y = positionY_[i] + (previousY_[i] - positionY_[i]) * blend;
+        instance->rect_ = glm::vec4(x, y, size.x, size.y);
+        instance->texcoords_ = DEFAULT_TEXTURE_COORDS;
+        instance->color_ = color_[i];
+        instance->texmask_ = texmask_[i];
+        instance->flags_ = 0x0;
+        instance->reserved_ = 0x0;
+        instance++;
+    }
+}
+
+void ParticleSystem::respawn(size_t index, uint32_t& random, const glm::vec4& bounds, bool initial) {
+
+    timeToLive_[index] = randomFloat(random, params_.minTimeToLive, params_.maxTimeToLive);
+    targetX_[index] = randomFloat(random, bounds.x, bounds.z);
+    targetY_[index] = randomFloat(random, bounds.y, bounds.w);
+
+    if (initial) {
+        auto color = hsvToRgb(randomFloat(random, 0.0f, 360.0f), 1.0f, 0.5f);
+        color_[index] = QuadInstance::packColor(color.r, color.g, color.b, color.a);
+    }
+
+    texmask_[index] = (randomFloat(random, 0.0f, 1.0f) > 0.5f) ? 2 : 1;
+}
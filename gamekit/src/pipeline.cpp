@@ -0,0 +1,641 @@
+/*
+ * Pipeline
+ */
+
+#include <vulkan>
+
+#include "gamekit/pipeline.h"
+#include "gamekit/device.h"
+#include "gamekit/utilities.h"
+
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <cassert>
+
+using namespace gamekit;
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline Cache
+///////////////////////////////////////////////////////////////////////////////
+
+void PipelineCache::create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& filename) {
+
+    destroy();
+
+    assert(nullptr != physicalDevice && nullptr != device);
+
+    filename_ = filename;
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    header_ = FileHeader{};
+    header_.vendorID = properties.vendorID;
+    header_.deviceID = properties.deviceID;
+    header_.driverVersion = properties.driverVersion;
+    std::memcpy(header_.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<uint8_t> data;
+    loaded_ = !filename_.empty() && load(data);
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = loaded_ ? data.size() : 0;
+    createInfo.pInitialData = loaded_ ? data.data() : nullptr;
+
+    auto res = vkCreatePipelineCache(device, &createInfo, nullptr, handle_.ref_ptr());
+    if (VK_SUCCESS != res && loaded_) {
+        // rejected by the driver, start over with an empty cache
+        loaded_ = false;
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        res = vkCreatePipelineCache(device, &createInfo, nullptr, handle_.ref_ptr());
+    }
+
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create pipeline cache: err={}", (int) res));
+    }
+}
+
+void PipelineCache::destroy() {
+    if (handle_.isNull()) return;
+
+    save();
+    handle_.free();
+    loaded_ = false;
+}
+
+bool PipelineCache::load(std::vector<uint8_t>& data) const {
+
+    std::ifstream file(filename_, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    FileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file) {
+        return false;
+    }
+
+    if (header.magic != MAGIC ||
+        header.version != VERSION ||
+        header.vendorID != header_.vendorID ||
+        header.deviceID != header_.deviceID ||
+        header.driverVersion != header_.driverVersion ||
+        0 != std::memcmp(header.pipelineCacheUUID, header_.pipelineCacheUUID, VK_UUID_SIZE)) {
+        return false; // other device or driver
+    }
+
+    // a truncated or corrupt file must not size the allocation
+    auto dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    auto fileEnd = file.tellg();
+    file.seekg(dataStart);
+    if (!file || fileEnd < dataStart || (uint64_t) (fileEnd - dataStart) != header.dataSize) {
+        return false;
+    }
+
+    data.resize((size_t) header.dataSize);
+    file.read(reinterpret_cast<char*>(data.data()), (std::streamsize) data.size());
+    if (!file) {
+        data.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool PipelineCache::save() const {
+
+    if (handle_.isNull() || filename_.empty()) {
+        return false;
+    }
+
+    auto device = Device::globalHandle();
+
+    size_t dataSize = 0;
+    auto res = vkGetPipelineCacheData(device, handle_.ptr(), &dataSize, nullptr);
+    if (VK_SUCCESS != res || 0 == dataSize) {
+        return false;
+    }
+
+    std::vector<uint8_t> data(dataSize);
+    res = vkGetPipelineCacheData(device, handle_.ptr(), &dataSize, data.data());
+    if (VK_SUCCESS != res) {
+        return false;
+    }
+
+    auto header = header_;
+    header.dataSize = dataSize;
+
+    // write aside and rename, an interrupted save never leaves a torn file
+    auto tempFilename = filename_ + ".tmp";
+
+    {
+        std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize) dataSize);
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::remove(filename_.c_str());
+    return 0 == std::rename(tempFilename.c_str(), filename_.c_str());
+}
+
+template <> void Reference<VkPipelineCache>::destroy() {
+    vkDestroyPipelineCache(Device::globalHandle(), handle_, nullptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline Description
+///////////////////////////////////////////////////////////////////////////////
+
+static void hashCombine(size_t& seed, size_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+template <typename T> static void hashValue(size_t& seed, const T& value) {
+    hashCombine(seed, std::hash<T>{}(value));
+}
+
+static bool sameBindings(const std::vector<VkDescriptorSetLayoutBinding>& a, const std::vector<VkDescriptorSetLayoutBinding>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const auto& x, const auto& y) {
+        return x.binding == y.binding && x.descriptorType == y.descriptorType &&
+               x.descriptorCount == y.descriptorCount && x.stageFlags == y.stageFlags;
+    });
+}
+
+static bool samePushConstants(const std::vector<VkPushConstantRange>& a, const std::vector<VkPushConstantRange>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const auto& x, const auto& y) {
+        return x.offset == y.offset && x.size == y.size && x.stageFlags == y.stageFlags;
+    });
+}
+
+bool PipelineDescription::isCompute() const {
+    return stages.size() == 1 && stages[0].stage == VK_SHADER_STAGE_COMPUTE_BIT;
+}
+
+size_t PipelineDescription::layoutHash() const {
+
+    size_t seed = 0;
+
+    for (const auto& binding : bindings) {
+        hashValue(seed, binding.binding);
+        hashValue(seed, (uint32_t) binding.descriptorType);
+        hashValue(seed, binding.descriptorCount);
+        hashValue(seed, (uint32_t) binding.stageFlags);
+    }
+
+    for (const auto& range : pushConstantRanges) {
+        hashValue(seed, range.offset);
+        hashValue(seed, range.size);
+        hashValue(seed, (uint32_t) range.stageFlags);
+    }
+
+    hashValue(seed, (const void*) textureTableLayout);
+
+    return seed;
+}
+
+size_t PipelineDescription::hash() const {
+
+    auto seed = layoutHash();
+
+    for (const auto& stage : stages) {
+        hashValue(seed, (uint32_t) stage.stage);
+        hashValue(seed, (const void*) stage.module);
+    }
+
+    if (isCompute()) return seed;
+
+    hashValue(seed, (int) vertexLayout);
+    hashValue(seed, (int) blendMode);
+    hashValue(seed, backfaceCulling);
+    hashValue(seed, frontFaceClockwise);
+    hashValue(seed, depthTesting);
+    hashValue(seed, depthWriting);
+    hashValue(seed, (const void*) renderPass);
+
+    return seed;
+}
+
+bool PipelineDescription::sameLayout(const PipelineDescription& other) const {
+    return sameBindings(bindings, other.bindings) &&
+           samePushConstants(pushConstantRanges, other.pushConstantRanges) &&
+           textureTableLayout == other.textureTableLayout;
+}
+
+bool PipelineDescription::operator==(const PipelineDescription& other) const {
+
+    auto sameStages = std::equal(stages.begin(), stages.end(), other.stages.begin(), other.stages.end(), [](const auto& x, const auto& y) {
+        return x.stage == y.stage && x.module == y.module;
+    });
+
+    if (!sameStages || !sameLayout(other)) return false;
+    if (isCompute()) return true;
+
+    return vertexLayout == other.vertexLayout &&
+           blendMode == other.blendMode &&
+           backfaceCulling == other.backfaceCulling &&
+           frontFaceClockwise == other.frontFaceClockwise &&
+           depthTesting == other.depthTesting &&
+           depthWriting == other.depthWriting &&
+           renderPass == other.renderPass;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Pipeline Registry
+///////////////////////////////////////////////////////////////////////////////
+
+const PipelineRegistry::Pipeline* PipelineRegistry::acquire(const PipelineDescription& description) {
+
+    // bindings in declaration order must not make otherwise equal materials differ
+    auto key = description;
+    std::sort(key.bindings.begin(), key.bindings.end(), [](const auto& a, const auto& b) {
+        return a.binding < b.binding;
+    });
+
+    auto hash = key.hash();
+
+    auto pipeline = std::make_unique<Pipeline>();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto existing = find(hash, key);
+        if (nullptr != existing) return existing;
+
+        pipeline->description = std::move(key);
+        pipeline->layout = acquireLayout(pipeline->description);
+    }
+
+    // compiled outside of the lock, other threads keep acquiring meanwhile
+    try {
+        if (pipeline->description.isCompute()) {
+            createComputePipeline(*pipeline);
+        } else {
+            createGraphicsPipeline(*pipeline);
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        releaseLayout(pipeline->layout);
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // lost a race against an equal description, keep the first one
+    auto existing = find(hash, pipeline->description);
+    if (nullptr != existing) {
+        releaseLayout(pipeline->layout);
+        return existing;
+    }
+
+    pipeline->refCount = 1;
+    pipeline->id = nextId_++;
+
+    auto it = pipelines_.emplace(hash, std::move(pipeline));
+    return it->second.get();
+}
+
+const PipelineRegistry::Pipeline* PipelineRegistry::find(size_t hash, const PipelineDescription& description) {
+
+    auto range = pipelines_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto& pipeline = *it->second;
+        if (pipeline.description == description) {
+            pipeline.refCount++;
+            return &pipeline;
+        }
+    }
+
+    return nullptr;
+}
+
+void PipelineRegistry::release(const Pipeline* pipeline) {
+
+    if (nullptr == pipeline) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto range = pipelines_.equal_range(pipeline->description.hash());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.get() != pipeline) continue;
+
+        auto& entry = *it->second;
+        assert(entry.refCount > 0);
+
+        if (0 == --entry.refCount) {
+            auto layout = entry.layout;
+            pipelines_.erase(it);
+            releaseLayout(layout);
+        }
+
+        return;
+    }
+}
+
+void PipelineRegistry::destroy() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // pipelines first, they reference the layouts
+    pipelines_.clear();
+    layouts_.clear();
+}
+
+size_t PipelineRegistry::pipelineCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pipelines_.size();
+}
+
+size_t PipelineRegistry::layoutCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return layouts_.size();
+}
+
+PipelineRegistry::Layout* PipelineRegistry::acquireLayout(const PipelineDescription& description) {
+
+    auto hash = description.layoutHash();
+
+    auto range = layouts_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto& layout = *it->second;
+        if (layout.description.sameLayout(description)) {
+            layout.refCount++;
+            return &layout;
+        }
+    }
+
+    auto device = Device::globalHandle();
+    VkResult res = VK_SUCCESS;
+
+    auto layout = std::make_unique<Layout>();
+    layout->description.bindings = description.bindings;
+    layout->description.pushConstantRanges = description.pushConstantRanges;
+    layout->description.textureTableLayout = description.textureTableLayout;
+
+    const auto& bindings = layout->description.bindings;
+    const auto& pushConstantRanges = layout->description.pushConstantRanges;
+
+    // bindless layouts need set 0 even without bindings, the texture table is set 1
+    if (bindings.size() > 0 || nullptr != description.textureTableLayout) {
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        res = vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, layout->descriptorSetLayout.ref_ptr());
+        if (VK_SUCCESS != res) {
+            throw std::runtime_error(Format::str("Failed to create descriptor set layout: err={}", (int) res));
+        }
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    if (nullptr != layout->descriptorSetLayout) setLayouts.push_back(layout->descriptorSetLayout.ptr());
+    if (nullptr != description.textureTableLayout) setLayouts.push_back(description.textureTableLayout);
+
+    if (setLayouts.size() > 0) {
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    }
+
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+    if (pushConstantRanges.size() > 0) {
+        pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+    }
+
+    res = vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, layout->pipelineLayout.ref_ptr());
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create pipeline layout: err={}", (int) res));
+    }
+
+    layout->refCount = 1;
+
+    auto it = layouts_.emplace(hash, std::move(layout));
+    return it->second.get();
+}
+
+void PipelineRegistry::releaseLayout(Layout* layout) {
+
+    if (nullptr == layout) return;
+
+    auto range = layouts_.equal_range(layout->description.layoutHash());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.get() != layout) continue;
+
+        assert(layout->refCount > 0);
+        if (0 == --layout->refCount) {
+            layouts_.erase(it);
+        }
+
+        return;
+    }
+}
+
+void PipelineRegistry::createComputePipeline(Pipeline& pipeline) {
+
+    auto device = Device::globalInstance();
+    assert(device);
+
+    const auto& description = pipeline.description;
+
+    VkPipelineShaderStageCreateInfo shaderStage{};
+    shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStage.module = description.stages[0].module;
+    shaderStage.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = shaderStage;
+    pipelineInfo.layout = pipeline.pipelineLayout();
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    auto res = vkCreateComputePipelines(device->handle(), device->pipelineCache(), 1, &pipelineInfo, nullptr, pipeline.handle.ref_ptr());
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create compute pipeline: err={}", (int) res));
+    }
+}
+
+void PipelineRegistry::createGraphicsPipeline(Pipeline& pipeline) {
+
+    auto device = Device::globalInstance();
+    assert(device);
+
+    const auto& description = pipeline.description;
+
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    for (const auto& stage : description.stages) {
+        auto& shaderStageCreateInfo = shaderStages.emplace_back();
+        shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStageCreateInfo.stage = stage.stage;
+        shaderStageCreateInfo.module = stage.module;
+        shaderStageCreateInfo.pName = "main";
+    }
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = nullptr; // ignored because of dynamic state
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = nullptr;  // ignored because of dynamic state
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkVertexInputBindingDescription vertexBindingDescription{};
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+
+    if (VertexLayout::QuadInstance == description.vertexLayout) {
+        auto instanceAttributes = QuadInstance::getAttributeDescriptions();
+        vertexBindingDescription = QuadInstance::getBindingDescription();
+        attributeDescriptions.assign(instanceAttributes.begin(), instanceAttributes.end());
+    } else {
+        auto vertexAttributes = Vertex::getAttributeDescriptions();
+        vertexBindingDescription = Vertex::getBindingDescription();
+        attributeDescriptions.assign(vertexAttributes.begin(), vertexAttributes.end());
+    }
+
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &vertexBindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = description.backfaceCulling ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+    rasterizer.frontFace = description.frontFaceClockwise ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+    rasterizer.depthBiasClamp = 0.0f; // Optional
+    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading = 1.0f; // Optional
+    multisampling.pSampleMask = nullptr; // Optional
+    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+    multisampling.alphaToOneEnable = VK_FALSE; // Optional
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = description.depthTesting ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = description.depthWriting ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    auto srcBlendFactor = VK_BLEND_FACTOR_ONE;
+    auto dstBlendFactor = VK_BLEND_FACTOR_ONE;
+
+    switch (description.blendMode) {
+        case BlendMode::Normal: {
+            srcBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            dstBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            break;
+        }
+        case BlendMode::Additive: {
+            srcBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            dstBlendFactor = VK_BLEND_FACTOR_ONE;
+            break;
+        }
+        case BlendMode::Multiply: {
+            srcBlendFactor = VK_BLEND_FACTOR_DST_COLOR;
+            dstBlendFactor = VK_BLEND_FACTOR_ZERO;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = srcBlendFactor;
+    colorBlendAttachment.dstColorBlendFactor = dstBlendFactor;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f; // Optional
+    colorBlending.blendConstants[1] = 0.0f; // Optional
+    colorBlending.blendConstants[2] = 0.0f; // Optional
+    colorBlending.blendConstants[3] = 0.0f; // Optional
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Dynamic state changes at draw time
+    ///////////////////////////////////////////////////////////////////////////////
+
+    std::vector<VkDynamicState> dynamicStates = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+        VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Pipeline
+    ///////////////////////////////////////////////////////////////////////////////
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = (uint32_t) shaderStages.size();
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = pipeline.pipelineLayout();
+    pipelineInfo.renderPass = description.renderPass;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex = -1; // Optional
+
+    auto res = vkCreateGraphicsPipelines(device->handle(), device->pipelineCache(), 1, &pipelineInfo, nullptr, pipeline.handle.ref_ptr());
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create graphics pipeline: err={}", (int) res));
+    }
+}
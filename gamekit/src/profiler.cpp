@@ -0,0 +1,159 @@
+/*
+ * Profiler
+ */
+
+#include <vulkan>
+
+#include "gamekit/profiler.h"
+#include "gamekit/device.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+using namespace gamekit;
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU Profiler
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::create(size_t frameCount, uint32_t timestampValidBits) {
+
+    destroy();
+
+    if (0 == timestampValidBits) {
+        return; // queue does not support timestamps, profiling stays disabled
+    }
+
+    auto physicalDevice = Device::globalInstance()->physicalDevice();
+    assert(nullptr != physicalDevice);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    timestampPeriod_ = (double) properties.limits.timestampPeriod;
+    timestampMask_ = (timestampValidBits >= 64) ? ~0ull : ((1ull << timestampValidBits) - 1);
+
+    frames_.resize(frameCount);
+    for (auto& frame : frames_) {
+        frame.queryPool = QueryPool::make(MAX_QUERIES);
+        frame.scopes.reserve(MAX_QUERIES / 2);
+    }
+}
+
+void GpuProfiler::destroy() {
+    for (auto& frame : frames_) {
+        frame.queryPool.destroy();
+    }
+    frames_.clear();
+    results_.clear();
+    current_ = nullptr;
+    commandBuffer_ = nullptr;
+    frameTime_ = 0.0;
+}
+
+void GpuProfiler::beginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer) {
+
+    if (frames_.empty()) return;
+
+    // called after the frame fence was waited for, so the queries
+    // written when this slot was last submitted are complete
+    auto& frame = frames_[frameIndex % frames_.size()];
+    resolve(frame);
+
+    frame.scopes.clear();
+    frame.queryCount = 0;
+
+    vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, MAX_QUERIES);
+
+    current_ = &frame;
+    commandBuffer_ = commandBuffer;
+}
+
+uint32_t GpuProfiler::beginScope(const char* name) {
+
+    if (nullptr == current_ || current_->queryCount + 2 > MAX_QUERIES) {
+        return npos;
+    }
+
+    auto scopeIndex = (uint32_t) current_->scopes.size();
+    auto& scope = current_->scopes.emplace_back();
+    scope.name = name;
+    scope.query = current_->queryCount;
+    current_->queryCount += 2;
+
+    vkCmdWriteTimestamp(commandBuffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current_->queryPool, scope.query);
+
+    return scopeIndex;
+}
+
+void GpuProfiler::endScope(uint32_t scope) {
+
+    if (npos == scope || nullptr == current_) {
+        return;
+    }
+
+    const auto& entry = current_->scopes[scope];
+    vkCmdWriteTimestamp(commandBuffer_, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current_->queryPool, entry.query + 1);
+}
+
+void GpuProfiler::resolve(FrameQueries& frame) {
+
+    if (0 == frame.queryCount) return;
+
+    // value and availability per query, never waits
+    std::vector<uint64_t> data(frame.queryCount * 2);
+
+    auto res = vkGetQueryPoolResults(Device::globalHandle(),
+                                     frame.queryPool,
+                                     0, frame.queryCount,
+                                     data.size() * sizeof(uint64_t), data.data(),
+                                     2 * sizeof(uint64_t),
+                                     VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if (VK_SUCCESS != res && VK_NOT_READY != res) {
+        return;
+    }
+
+    results_.clear();
+
+    uint64_t frameBegin = ~0ull;
+    uint64_t frameEnd = 0;
+
+    for (const auto& scope : frame.scopes) {
+        auto beginValue = data[scope.query * 2];
+        auto beginAvailable = data[scope.query * 2 + 1];
+        auto endValue = data[(scope.query + 1) * 2];
+        auto endAvailable = data[(scope.query + 1) * 2 + 1];
+
+        if (0 == beginAvailable || 0 == endAvailable) continue;
+
+        beginValue &= timestampMask_;
+        endValue &= timestampMask_;
+        if (endValue < beginValue) continue;
+
+        frameBegin = std::min(frameBegin, beginValue);
+        frameEnd = std::max(frameEnd, endValue);
+
+        auto time = (double) (endValue - beginValue) * timestampPeriod_ * 0.001;
+
+        Result* result = nullptr;
+        for (auto& entry : results_) {
+            if (entry.name == scope.name || 0 == std::strcmp(entry.name, scope.name)) {
+                result = &entry;
+                break;
+            }
+        }
+
+        if (nullptr == result) {
+            result = &results_.emplace_back();
+            result->name = scope.name;
+        }
+
+        result->time += time;
+        result->count++;
+    }
+
+    frameTime_ = (frameEnd > frameBegin) ? (double) (frameEnd - frameBegin) * timestampPeriod_ * 0.001 : 0.0;
+    resolvedFrames_++;
+}
@@ -0,0 +1,370 @@
+/*
+ * Render Queue
+ */
+
+#include <vulkan>
+
+#include "gamekit/render_queue.h"
+#include "gamekit/material.h"
+#include "gamekit/device.h"
+#include "gamekit/utilities.h"
+
+#include <array>
+#include <future>
+#include <exception>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+using namespace gamekit;
+
+uint64_t RenderQueue::makeKey(uint32_t layer, uint32_t pipelineId, uint32_t materialId, VkBuffer vertexBuffer, float depth) {
+
+    // buffer handles are folded to 16 bits, collisions only cost a rebind
+    auto bufferBits = (uint64_t) (uintptr_t) vertexBuffer;
+    bufferBits ^= bufferBits >> 16;
+    bufferBits ^= bufferBits >> 32;
+
+    auto depthBits = (uint64_t) (std::clamp(depth, 0.0f, 1.0f) * 4095.0f);
+
+    return ((uint64_t) (std::min(layer, MAX_LAYERS - 1)) << 60) |
+           ((uint64_t) (pipelineId & 0xffff) << 44) |
+           ((uint64_t) (materialId & 0xffff) << 28) |
+           ((bufferBits & 0xffff) << 12) |
+           (depthBits & 0xfff);
+}
+
+void RenderQueue::submit(const DrawCommand& command, uint32_t layer, float depth) {
+
+    assert(nullptr != command.material);
+
+    if (0 == command.count || 0 == command.instances) return;
+
+    auto material = command.material;
+    auto pipelineId = material->isReady() ? material->pipeline()->id : 0;
+    auto key = makeKey(layer, pipelineId, material->id(), command.vertexBuffer, depth);
+
+    items_.push_back({ key, (uint32_t) commands_.size() });
+    commands_.push_back(command);
+}
+
+void RenderQueue::clear() {
+    commands_.clear();
+    items_.clear();
+}
+
+void RenderQueue::sort() {
+
+    auto num = items_.size();
+    if (num < 2) return;
+
+    scratch_.resize(num);
+
+    // lsd radix sort on 8 bit digits, passes where all keys share the digit are skipped
+    std::array<size_t, 256> histogram;
+
+    auto* source = &items_;
+    auto* target = &scratch_;
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+
+        histogram.fill(0);
+        for (const auto& item : *source) {
+            histogram[(item.key >> shift) & 0xff]++;
+        }
+
+        auto firstDigit = ((*source)[0].key >> shift) & 0xff;
+        if (histogram[firstDigit] == num) continue;
+
+        size_t offset = 0;
+        for (auto& count : histogram) {
+            auto value = count;
+            count = offset;
+            offset += value;
+        }
+
+        for (const auto& item : *source) {
+            (*target)[histogram[(item.key >> shift) & 0xff]++] = item;
+        }
+
+        std::swap(source, target);
+    }
+
+    if (source != &items_) {
+        items_.swap(scratch_);
+    }
+}
+
+void RenderQueue::flush() {
+
+    statistics_ = Statistics{};
+
+    if (commands_.empty()) return;
+
+    sort();
+
+    auto device = Device::globalInstance();
+    const auto& frame = device->currentFrame();
+
+    GpuScope scope(device->profiler(), "renderqueue");
+
+    record(frame.commandBuffer, 0, items_.size(), frame.index, statistics_);
+
+    clear();
+}
+
+void RenderQueue::flushParallel(VkRenderPass renderPass, VkFramebuffer framebuffer, const VkExtent2D& extent) {
+
+    statistics_ = Statistics{};
+
+    if (commands_.empty()) return;
+
+    sort();
+
+    auto device = Device::globalInstance();
+    const auto& frame = device->currentFrame();
+    auto& workers = device->workers();
+
+    // timed by Device::endDraw, the primary buffer may only execute
+    // secondary command buffers inside the continued subpass
+
+    // contiguous ranges of the sorted list, the calling thread records the first one
+    auto numItems = items_.size();
+    auto numChunks = std::min(workers.size() + 1, (numItems + MIN_DRAWS_PER_THREAD - 1) / MIN_DRAWS_PER_THREAD);
+    numChunks = std::max(numChunks, (size_t) 1);
+    auto chunkSize = (numItems + numChunks - 1) / numChunks;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = framebuffer;
+
+    VkViewport viewport{};
+    viewport.width = (float) extent.width;
+    viewport.height = (float) extent.height;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.extent = extent;
+
+    std::vector<VkCommandBuffer> commandBuffers(numChunks);
+    std::vector<Statistics> statistics(numChunks);
+
+    // pools are not thread safe, allocate and begin on this thread
+    for (size_t chunk = 0; chunk < numChunks; chunk++) {
+        commandBuffers[chunk] = beginSecondary(frame.index, chunk, inheritanceInfo);
+    }
+
+    auto recordChunk = [&](size_t chunk) {
+        auto commandBuffer = commandBuffers[chunk];
+
+        // secondary command buffers inherit no state: dynamic state is set here,
+        // record() binds pipeline, sets and push constants at the first material
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        auto first = chunk * chunkSize;
+        auto last = std::min(first + chunkSize, numItems);
+        record(commandBuffer, first, last, frame.index, statistics[chunk]);
+
+        auto res = vkEndCommandBuffer(commandBuffer);
+        if (VK_SUCCESS != res) {
+            throw std::runtime_error(Format::str("Failed to record secondary command buffer: err={}", (int) res));
+        }
+    };
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(numChunks);
+
+    for (size_t chunk = 1; chunk < numChunks; chunk++) {
+        pending.emplace_back(workers.submit([&recordChunk, chunk]() { recordChunk(chunk); }));
+    }
+
+    // workers reference the locals of this frame, all of them are
+    // finished before an error of any chunk leaves the function
+    std::exception_ptr error;
+
+    try {
+        recordChunk(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    for (auto& result : pending) {
+        try {
+            result.get();
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    vkCmdExecuteCommands(frame.commandBuffer, static_cast<uint32_t>(numChunks), commandBuffers.data());
+
+    for (const auto& chunkStatistics : statistics) {
+        statistics_.draws += chunkStatistics.draws;
+        statistics_.pipelineBinds += chunkStatistics.pipelineBinds;
+        statistics_.descriptorSetBinds += chunkStatistics.descriptorSetBinds;
+        statistics_.vertexBufferBinds += chunkStatistics.vertexBufferBinds;
+        statistics_.indexBufferBinds += chunkStatistics.indexBufferBinds;
+    }
+
+    clear();
+}
+
+VkCommandBuffer RenderQueue::beginSecondary(size_t frameIndex, size_t chunk, const VkCommandBufferInheritanceInfo& inheritanceInfo) {
+
+    auto device = Device::globalInstance();
+
+    if (recorders_.size() <= frameIndex) {
+        recorders_.resize(device->frameCount());
+    }
+
+    auto& recorders = recorders_[frameIndex];
+    if (recorders.size() <= chunk) {
+        recorders.resize(chunk + 1);
+    }
+
+    auto& recorder = recorders[chunk];
+    VkResult res = VK_SUCCESS;
+
+    if (recorder.commandPool.isNull()) {
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = device->graphicsFamilyIndex();
+
+        res = vkCreateCommandPool(device->handle(), &poolInfo, nullptr, recorder.commandPool.ref_ptr());
+        if (VK_SUCCESS != res) {
+            throw std::runtime_error(Format::str("Failed to create command pool: err={}", (int) res));
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = recorder.commandPool.ptr();
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer = nullptr;
+        res = vkAllocateCommandBuffers(device->handle(), &allocInfo, &commandBuffer);
+        if (VK_SUCCESS != res) {
+            throw std::runtime_error(Format::str("Failed to allocate command buffer: err={}", (int) res));
+        }
+
+        recorder.commandBuffer.attach(commandBuffer);
+
+    } else {
+        // the frame slot's fence has been waited for, its previous recording is done
+        vkResetCommandPool(device->handle(), recorder.commandPool.ptr(), 0);
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    res = vkBeginCommandBuffer(recorder.commandBuffer.ptr(), &beginInfo);
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to begin recording command buffer: err={}", (int) res));
+    }
+
+    return recorder.commandBuffer.ptr();
+}
+
+void RenderQueue::destroy() {
+    clear();
+    recorders_.clear();
+}
+
+void RenderQueue::record(VkCommandBuffer commandBuffer, size_t first, size_t last, size_t frameIndex, Statistics& statistics) const {
+
+    // bound state, only changes are recorded
+    Material* material = nullptr;
+    VkPipeline pipeline = nullptr;
+    VkDescriptorSet descriptorSet = nullptr;
+    VkPipelineLayout setLayout = nullptr;       // of the last set 0 bind
+    VkPipelineLayout tableLayout = nullptr;     // of the last texture table bind
+    VkBuffer vertexBuffer = nullptr;
+
+    auto& textureTable = Device::globalInstance()->textureTable();
+    VkBuffer indexBuffer = nullptr;
+
+    for (size_t i = first; i < last; i++) {
+
+        const auto& command = commands_[items_[i].index];
+
+        if (command.material != material) {
+
+            if (!command.material->isReady()) continue; // first pipeline still compiling
+
+            material = command.material;
+
+            const auto* materialPipeline = material->pipeline();
+
+            if (materialPipeline->ptr() != pipeline) {
+                pipeline = materialPipeline->ptr();
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                statistics.pipelineBinds++;
+            }
+
+            material->setDynamicStates(commandBuffer);
+
+            const auto& materialDescriptorSet = material->descriptorSet(frameIndex);
+
+            if (materialDescriptorSet.ptr() != descriptorSet) {
+                descriptorSet = materialDescriptorSet.ptr();
+                vkCmdBindDescriptorSets(commandBuffer,
+                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                        materialPipeline->pipelineLayout(),
+                                        0, 1, materialDescriptorSet.ref_ptr(),
+                                        0, nullptr);
+                statistics.descriptorSetBinds++;
+
+                // set 0 of another layout may disturb the texture table binding
+                if (materialPipeline->pipelineLayout() != setLayout) {
+                    setLayout = materialPipeline->pipelineLayout();
+                    tableLayout = nullptr;
+                }
+            }
+
+            // the texture table is shared, only layout changes rebind it
+            if (materialPipeline->isBindless() && materialPipeline->pipelineLayout() != tableLayout) {
+                tableLayout = materialPipeline->pipelineLayout();
+                vkCmdBindDescriptorSets(commandBuffer,
+                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                        tableLayout,
+                                        TextureTable::SET, 1, textureTable.descriptorSet().ref_ptr(),
+                                        0, nullptr);
+                statistics.descriptorSetBinds++;
+            }
+
+            // pushes of onDraw were only stored, each material gets its own
+            material->recordPushConstants(commandBuffer);
+        }
+
+        if (command.vertexBuffer != vertexBuffer) {
+            vertexBuffer = command.vertexBuffer;
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+            statistics.vertexBufferBinds++;
+        }
+
+        if (nullptr != command.indexBuffer) {
+            if (command.indexBuffer != indexBuffer) {
+                indexBuffer = command.indexBuffer;
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+                statistics.indexBufferBinds++;
+            }
+            vkCmdDrawIndexed(commandBuffer, command.count, command.instances, command.first, 0, 0);
+        } else {
+            vkCmdDraw(commandBuffer, command.count, command.instances, command.first, 0);
+        }
+
+        statistics.draws++;
+    }
+}
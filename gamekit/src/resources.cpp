@@ -3,60 +3,511 @@
  */
 
 #include "gamekit/resources.h"
+#include "gamekit/device.h"
 #include "gamekit/utilities.h"
 
 #include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <cerrno>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <atomic>
 #include <stdexcept>
 #include <cassert>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
 using namespace gamekit;
 
+static bool isImageType(ResourceType type) {
+    return ResourceType::Bitmap == type || ResourceType::CompressedBitmap == type;
+}
+
+static bool isShaderType(ResourceType type) {
+    return ResourceType::VertexShader == type || ResourceType::FragmentShader == type || ResourceType::ComputeShader == type;
+}
+
+static std::vector<uint8_t> readFile(const std::string& filename) {
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(Format::str("failed to read file: ", filename.c_str()));
+    }
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+#ifdef _WIN32
+static std::string quoteArgument(const std::string& arg) {
+
+    // CommandLineToArgvW rules: backslashes are literal unless they precede a quote
+    std::string result = "\"";
+    size_t backslashes = 0;
+
+    for (auto c : arg) {
+        if ('\\' == c) {
+            backslashes++;
+            continue;
+        }
+        result.append(('"' == c) ? backslashes * 2 + 1 : backslashes, '\\');
+        result.push_back(c);
+        backslashes = 0;
+    }
+
+    result.append(backslashes * 2, '\\');
+    result.push_back('"');
+
+    return result;
+}
+#endif
+
+// runs a tool without a shell, file names are passed through unchanged.
+// returns the exit code, -1 if the process could not be started
+static int runProcess(const std::vector<std::string>& args) {
+
+#ifdef _WIN32
+    std::string commandLine;
+    for (const auto& arg : args) {
+        if (!commandLine.empty()) commandLine.push_back(' ');
+        commandLine += quoteArgument(arg);
+    }
+
+    STARTUPINFOA startupInfo{};
+    startupInfo.cb = sizeof(startupInfo);
+    PROCESS_INFORMATION processInfo{};
+
+    if (!CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo)) {
+        return -1;
+    }
+
+    WaitForSingleObject(processInfo.hProcess, INFINITE);
+
+    DWORD exitCode = 0;
+    auto status = GetExitCodeProcess(processInfo.hProcess, &exitCode);
+
+    CloseHandle(processInfo.hThread);
+    CloseHandle(processInfo.hProcess);
+
+    return status ? (int) exitCode : -1;
+#else
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = 0;
+    if (0 != posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ)) {
+        return -1;
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (EINTR != errno) return -1;
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+static std::filesystem::path uniqueTempFile(const std::string& suffix) {
+
+    // other applications and same named shaders share the temp folder
+    static std::atomic<uint32_t> counter{0};
+
+#ifdef _WIN32
+    auto pid = (unsigned long) GetCurrentProcessId();
+#else
+    auto pid = (unsigned long) getpid();
+#endif
+
+    auto name = "gamekit-" + std::to_string(pid) + "-" + std::to_string(counter.fetch_add(1)) + suffix;
+
+    return std::filesystem::temp_directory_path() / name;
+}
+
+static std::vector<uint8_t> compileShader(const std::string& filename) {
+
+    namespace fs = std::filesystem;
+
+    // same toolchain and target as gamekitc, glslc from the path without an sdk
+    auto sdk = std::getenv("VULKAN_SDK");
+    auto glslc = (nullptr != sdk) ? (fs::path(sdk) / "bin" / "glslc").string() : std::string("glslc");
+
+    auto output = uniqueTempFile("-" + fs::path(filename).filename().string() + ".spv");
+
+    auto result = runProcess({ glslc, "--target-env=vulkan1.2", "-o", output.string(), filename });
+    if (0 != result) {
+        std::error_code ec;
+        fs::remove(output, ec);
+        throw std::runtime_error(Format::str("failed to compile shader: ", filename.c_str()));
+    }
+
+    auto code = readFile(output.string());
+
+    std::error_code ec;
+    fs::remove(output, ec);
+
+    return code;
+}
+
 void Resources::create(const std::vector<gamekit::ResourceDescriptor>& resourceDescriptors) {
     for (const auto& descriptor : resourceDescriptors) {
-        auto id = descriptor.name;
-        descriptors_[id] = descriptor;
+        auto id = makeResourceId(descriptor.name);
+        auto existing = descriptors_.find(id);
+        if (nullptr != existing) {
+            if (existing->name != descriptor.name) {
+                throw std::runtime_error(Format::str("resource id collision: ", descriptor.name.c_str()));
+            }
+            *existing = descriptor;
+            continue;
+        }
+        descriptors_.insert(id, ResourceDescriptor(descriptor));
     }
 }
 
 void Resources::destroy() {
+
+    // workers must not outlive the loads they decode for
+    for (auto& entry : loads_) {
+        auto& load = *entry.second;
+        if (load.decoded_.valid()) load.decoded_.wait();
+        load.error_ = "cancelled";
+        load.state_.store(LoadState::Failed, std::memory_order_release);
+    }
+
+    watcher_.destroy();
+    loads_.clear();
     shaders_.clear();
     images_.clear();
     textures_.clear();
+    atlases_.clear();
 }
 
-const ResourceDescriptor& Resources::get(const std::string& id) const {
-    auto it = descriptors_.find(id);
-    if (it == descriptors_.end()) {
-        throw std::runtime_error(Format::str("could not find resource: ", id.c_str()));
+const ResourceDescriptor& Resources::get(ResourceId id) const {
+    auto descriptor = descriptors_.find(id);
+    if (nullptr == descriptor) {
+        char text[20];
+        std::snprintf(text, sizeof(text), "0x%016llx", (unsigned long long) id);
+        throw std::runtime_error(Format::str("could not find resource: ", text));
     }
-    return it->second;
+    return *descriptor;
 }
 
-const Shader& Resources::getShader(const std::string& id) {
-    auto it = shaders_.find(id);
-    if (it == shaders_.end()) {
-        auto res = shaders_.emplace(std::make_pair(id, Shader::make(get(id))));
-        return res.first->second;
+const Shader& Resources::getShader(ResourceId id) {
+    auto shader = shaders_.find(id);
+    if (nullptr == shader) {
+        return shaders_.insert(id, Shader::make(get(id)));
     }
-    return it->second;
+    return *shader;
 }
 
-const Image& Resources::getImage(const std::string& id) {
-    auto it = images_.find(id);
-    if (it == images_.end()) {
-        auto res = images_.emplace(std::make_pair(id, Image::make(get(id))));
-        return res.first->second;
+const Image& Resources::getImage(ResourceId id) {
+    auto image = images_.find(id);
+    if (nullptr == image) {
+
+        // an async load in flight is finished rather than decoded twice
+        auto loadIt = loads_.find(id);
+        if (loadIt != loads_.end()) {
+            auto load = loadIt->second;
+            loads_.erase(loadIt);
+            finishLoad(*load);
+            if (load->isFailed()) {
+                throw std::runtime_error(load->error());
+            }
+            return *images_.find(id);
+        }
+
+        return images_.insert(id, Image::make(get(id)));
     }
-    return it->second;
+    return *image;
 }
 
-const Texture& Resources::getTexture(const std::string& id) {
-    auto it = textures_.find(id);
-    if (it == textures_.end()) {
-        auto res = textures_.emplace(std::make_pair(id, Texture::make(getImage(id))));
-        return res.first->second;
+const Texture& Resources::getTexture(ResourceId id) {
+    auto texture = textures_.find(id);
+    if (nullptr == texture) {
+        return textures_.insert(id, Texture::make(getImage(id)));
     }
-    return it->second;
+    return *texture;
+}
+
+const Atlas& Resources::getAtlas(ResourceId id) {
+    auto atlas = atlases_.find(id);
+    if (nullptr == atlas) {
+        return atlases_.insert(id, Atlas::make(get(id)));
+    }
+    return *atlas;
+}
+
+LoadHandle Resources::loadAsync(ResourceId id) {
+
+    auto it = loads_.find(id);
+    if (it != loads_.end()) {
+        return it->second;
+    }
+
+    const auto& descriptor = get(id);
+
+    auto load = std::make_shared<ResourceLoad>();
+    load->id_ = descriptor.name;
+    load->resourceId_ = id;
+    load->type_ = descriptor.type;
+
+    if (isLoaded(id, descriptor.type)) {
+        load->state_.store(LoadState::Ready, std::memory_order_release);
+        return load;
+    }
+
+    if (isImageType(descriptor.type)) {
+        auto device = Device::globalInstance();
+        assert(nullptr != device);
+
+        // decoding only reads the descriptor data, the upload stays on the render thread
+        load->decoded_ = device->workers().submit([descriptor]() {
+            return Image::decode(descriptor);
+        });
+    }
+
+    loads_.emplace(id, load);
+
+    return load;
+}
+
+void Resources::preload(std::initializer_list<std::string_view> names) {
+
+    std::vector<ResourceId> ids;
+    ids.reserve(names.size());
+
+    for (const auto& name : names) {
+        ids.push_back(makeResourceId(name));
+    }
+
+    preload(ids);
+}
+
+void Resources::preload(const std::vector<ResourceId>& ids) {
+
+    std::vector<LoadHandle> handles;
+    handles.reserve(ids.size());
+
+    for (auto id : ids) {
+        handles.push_back(loadAsync(id));
+    }
+
+    auto device = Device::globalInstance();
+    assert(nullptr != device);
+
+    // upload in request order while the workers keep decoding the rest,
+    // submitting regularly lets the staging memory be recycled
+    size_t recorded = 0;
+
+    for (const auto& handle : handles) {
+        auto it = loads_.find(handle->resourceId());
+        if (it == loads_.end()) continue;
+
+        auto load = it->second;
+        loads_.erase(it);
+
+        recorded += finishLoad(*load);
+        if (recorded >= DEFAULT_UPLOAD_BUDGET) {
+            device->flushTransfers(false);
+            recorded = 0;
+        }
+    }
+
+    device->flushTransfers(true);
+
+    for (const auto& handle : handles) {
+        if (handle->isFailed()) {
+            throw std::runtime_error(Format::str("failed to preload resource: ", handle->error().c_str()));
+        }
+    }
+}
+
+void Resources::update(size_t uploadBudget) {
+
+    if (watcher_.isWatching()) {
+        reloadChanged();
+    }
+
+    if (loads_.empty()) return;
+
+    // bounded per call so streaming does not stall the frame,
+    // at least one load is finished to guarantee progress
+    size_t uploaded = 0;
+
+    for (auto it = loads_.begin(); it != loads_.end() && uploaded < uploadBudget; ) {
+        auto& load = *it->second;
+
+        if (load.decoded_.valid() && std::future_status::ready != load.decoded_.wait_for(std::chrono::seconds(0))) {
+            ++it;
+            continue;
+        }
+
+        auto keep = it->second;
+        it = loads_.erase(it);
+        uploaded += finishLoad(*keep);
+    }
+}
+
+bool Resources::isLoaded(ResourceId id, ResourceType type) const {
+    if (isImageType(type)) return images_.contains(id);
+    if (isShaderType(type)) return shaders_.contains(id);
+    if (ResourceType::Atlas == type) return atlases_.contains(id);
+    return true; // raw data is served from the descriptor
+}
+
+size_t Resources::finishLoad(ResourceLoad& load) {
+
+    size_t uploaded = 0;
+
+    try {
+        if (isImageType(load.type_)) {
+            auto source = load.decoded_.get(); // rethrows decode errors
+            if (!images_.contains(load.resourceId_)) {
+                images_.insert(load.resourceId_, Image::make(source));
+                uploaded = source.dataSize;
+            }
+        } else if (isShaderType(load.type_)) {
+            getShader(load.resourceId_);
+        } else if (ResourceType::Atlas == load.type_) {
+            getAtlas(load.resourceId_);
+        }
+
+        load.state_.store(LoadState::Ready, std::memory_order_release);
+
+    } catch (const std::exception& e) {
+        load.error_ = e.what();
+        load.state_.store(LoadState::Failed, std::memory_order_release);
+    }
+
+    return uploaded;
+}
+
+void Resources::watch(const std::string& sourceFolder) {
+    watcher_ = FileWatcher::make(sourceFolder);
+}
+
+void Resources::reloadChanged() {
+
+    for (const auto& filename : watcher_.poll()) {
+
+        // names are the lower case source paths, see gamekitc
+        std::string name(filename);
+        for (auto& c : name) c = (char) std::tolower((unsigned char) c);
+
+        // a broken shader or image keeps the previous version running
+        try {
+            if (reload(name, (std::filesystem::path(watcher_.folder()) / filename).string())) {
+                std::cout << "reloaded resource: " << name << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cout << "failed to reload resource: " << name << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+bool Resources::reload(std::string_view name, const std::string& filename) {
+
+    auto id = makeResourceId(name);
+
+    auto descriptor = descriptors_.find(id);
+    if (nullptr == descriptor) return false;
+
+    auto type = descriptor->type;
+
+    std::vector<uint8_t> data;
+
+    if (isShaderType(type)) {
+        data = compileShader(filename);
+    } else if (isImageType(type)) {
+        data = readFile(filename);
+        type = ResourceType::Bitmap; // block compression is left to the next build
+    } else if (ResourceType::Data == type || ResourceType::Text == type) {
+        data = readFile(filename);
+    } else {
+        return false; // atlases are packed from whole folders at build time
+    }
+
+    // an async decode in flight still reads the previous data
+    auto loadIt = loads_.find(id);
+    if (loadIt != loads_.end()) {
+        auto load = loadIt->second;
+        loads_.erase(loadIt);
+        finishLoad(*load);
+    }
+
+    auto device = Device::globalInstance();
+    assert(nullptr != device);
+
+    // create the replacements before anything is swapped, a failing
+    // decode or module creation leaves the loaded version untouched
+    ResourceDescriptor next{ descriptor->name, data.data(), data.size(), type };
+
+    auto shader = shaders_.find(id);
+    auto image = images_.find(id);
+    auto texture = textures_.find(id);
+
+    Shader nextShader;
+    Image nextImage;
+    Texture nextTexture;
+
+    if (nullptr != shader) nextShader = Shader::make(next);
+    if (nullptr != image) nextImage = Image::make(next);
+    if (nullptr != texture) nextTexture = Texture::make(nextImage);
+
+    auto stored = reloaded_.find(id);
+    if (nullptr == stored) {
+        stored = &reloaded_.insert(id, std::move(data));
+    } else {
+        *stored = std::move(data);
+    }
+
+    descriptor->data = stored->data();
+    descriptor->dataSize = stored->size();
+    descriptor->type = type;
+
+    if (nullptr == shader && nullptr == image) return true;
+
+    // frames in flight still use the replaced objects, fine for development builds
+    device->flushTransfers(true);
+    device->waitIdle();
+
+    // swapped in place, materials keep their pointers. the previous objects
+    // are destroyed after the materials let go of them, views before images
+    Shader previousShader;
+    Image previousImage;
+    Texture previousTexture;
+
+    if (nullptr != shader) {
+        previousShader = std::exchange(*shader, std::move(nextShader));
+        device->invalidate(*shader);
+    }
+
+    if (nullptr != image) {
+        previousImage = std::exchange(*image, std::move(nextImage));
+    }
+
+    if (nullptr != texture) {
+        previousTexture = std::exchange(*texture, std::move(nextTexture));
+        device->invalidate(*texture);
+    }
+
+    return true;
 }
@@ -9,6 +9,8 @@
 #include <gamekit/texture.h>
 #include <gamekit/buffer.h>
 #include "gamekit/sprite.h"
+#include "gamekit/atlas.h"
+#include "gamekit/utilities.h"
 
 #include <array>
 #include <stdexcept>
@@ -59,6 +61,18 @@ void Quad::draw() {
     device->drawIndexed(numIndices);
 }
 
+void Quad::submit(RenderQueue& queue, Material& material, uint32_t layer, float depth) {
+    update();
+
+    DrawCommand command;
+    command.material = &material;
+    command.vertexBuffer = vertexBuffer_.handle();
+    command.indexBuffer = indexBuffer_.handle();
+    command.count = static_cast<uint32_t>(indices_.size());
+
+    queue.submit(command, layer, depth);
+}
+
 void Quad::update() {
 
     if (!modified_) {
@@ -173,3 +187,11 @@ Sprite Sprite::make() {
 
 void Sprite::create() {
 }
+
+void Sprite::setFrame(const Atlas& atlas, const std::string& name) {
+    auto index = atlas.frameIndex(name);
+    if (Atlas::npos == index) {
+        throw std::runtime_error(Format::str("could not find atlas frame", name.c_str()));
+    }
+    frame_ = (int) index;
+}
@@ -11,7 +11,9 @@
 #include "gamekit/sprite_batch.h"
 
 #include <array>
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 #include <glm/glm.hpp>
 
 using namespace gamekit;
@@ -25,13 +27,36 @@ static const uint32_t DEFAULT_FLAGS = 0x0;
 // Vertex Queue
 ///////////////////////////////////////////////////////////////////////////////
 
-VertexQueue VertexQueue::make(size_t capacity) {
+VertexQueue VertexQueue::make(size_t capacity, bool streaming) {
     VertexQueue quadBatch;
-    quadBatch.create(capacity);
+    quadBatch.create(capacity, streaming);
     return quadBatch;
 }
 
-void VertexQueue::create(size_t capacity) {
+VertexQueue::VertexQueue(VertexQueue&& ref) {
+    *this = std::move(ref);
+}
+
+VertexQueue& VertexQueue::operator=(VertexQueue&& ref) {
+    capacity_ = ref.capacity_;
+    reserved_ = ref.reserved_;
+    count_.store(ref.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    modified_ = ref.modified_;
+    vertexData_ = ref.vertexData_;     // vector move keeps the storage address
+    vertices_ = std::move(ref.vertices_);
+    indices_ = std::move(ref.indices_);
+    vertexBuffer_ = std::move(ref.vertexBuffer_);
+    indexBuffer_ = std::move(ref.indexBuffer_);
+
+    ref.capacity_ = 0;
+    ref.reserved_ = 0;
+    ref.count_.store(0, std::memory_order_relaxed);
+    ref.vertexData_ = nullptr;
+
+    return *this;
+}
+
+void VertexQueue::create(size_t capacity, bool streaming) {
 
     assert(capacity > 0);
 
@@ -42,7 +67,6 @@ void VertexQueue::create(size_t capacity) {
     auto numIndices = capacity_ * 6;
     auto numVertices = capacity_ * 4;
 
-    vertices_.resize(numVertices);
     indices_.resize(numIndices);
 
     auto ptr = indices_.data();
@@ -66,15 +90,36 @@ void VertexQueue::create(size_t capacity) {
     indexBuffer_ = IndexBuffer::make(numIndices * sizeof(uint16_t));
     indexBuffer_.copy(indices_.data());
 
-    vertexBuffer_ = VertexBuffer::make(numVertices * sizeof(Vertex));
+    if (streaming) {
+        // vertices are written straight into the mapped per-frame buffer
+        vertices_.clear();
+        vertexBuffer_ = VertexBuffer::makeStreaming(numVertices * sizeof(Vertex));
+        vertexData_ = static_cast<Vertex*>(vertexBuffer_.data(0));
+    } else {
+        vertices_.resize(numVertices);
+        vertexBuffer_ = VertexBuffer::make(numVertices * sizeof(Vertex));
+        vertexData_ = vertices_.data();
+    }
 }
 
 void VertexQueue::begin() {
     count_ = 0;
+
+    if (vertexBuffer_.isStreaming()) {
+        // the frame slot is going to be recorded next, make sure the
+        // gpu is done reading its vertex region before overwriting it.
+        // reserved entries must be stored again for every frame.
+        const auto& frame = Device::globalInstance()->currentFrame();
+        frame.commandBuffersCompleted.wait();
+        vertexData_ = static_cast<Vertex*>(vertexBuffer_.data(frame.index));
+    }
 }
 
 void VertexQueue::end() {
-
+    // concurrent pushes only bump the cursor, flag the batch here
+    if (count_.load(std::memory_order_acquire) > 0) {
+        modified_ = true;
+    }
 }
 
 void VertexQueue::clear() {
@@ -102,13 +147,18 @@ size_t VertexQueue::reserve(size_t numIndices) {
 
 void VertexQueue::update() {
 
-    auto num = count_ + reserved_;
+    auto num = used();
 
     if (!modified_ || 0 == num) {
         return;
     }
 
     modified_ = false;
+
+    if (vertexBuffer_.isStreaming()) {
+        return; // host coherent memory, already visible to the gpu
+    }
+
     auto numVertices = num * 4;
     vertexBuffer_.copy(vertices_.data(), sizeof(Vertex) * numVertices);
 }
@@ -116,7 +166,7 @@ void VertexQueue::update() {
 void VertexQueue::draw() {
     update();
 
-    auto num = count_ + reserved_;
+    auto num = used();
 
     if (0 == num) return;
 
@@ -127,6 +177,22 @@ void VertexQueue::draw() {
     device->drawIndexed(numIndices);
 }
 
+void VertexQueue::submit(RenderQueue& queue, Material& material, uint32_t layer, float depth) {
+    update();
+
+    auto num = used();
+
+    if (0 == num) return;
+
+    DrawCommand command;
+    command.material = &material;
+    command.vertexBuffer = vertexBuffer_.handle();
+    command.indexBuffer = indexBuffer_.handle();
+    command.count = static_cast<uint32_t>(num * 6);
+
+    queue.submit(command, layer, depth);
+}
+
 inline void VertexQueue::setCoords(size_t index, const glm::vec4* coords) {
     setCoords(index, coords->x, coords->y, coords->z, coords->w);
 }
@@ -141,7 +207,7 @@ inline void VertexQueue::setCoords(size_t index, float x, float y, float w, floa
 
     auto ofs = index * 4;
 
-    auto v = vertices_.data() + ofs;
+    auto v = vertexData_ + ofs;
     v->setPos(x0, y0, z); v++;
     v->setPos(x1, y0, z); v++;
     v->setPos(x1, y1, z); v++;
@@ -156,7 +222,7 @@ inline void VertexQueue::setColor(size_t index, const glm::vec4* color) {
 inline void VertexQueue::setColor(size_t index, float r, float g, float b, float a) {
 
     auto ofs = index * 4;
-    auto v = vertices_.data() + ofs;
+    auto v = vertexData_ + ofs;
     v->setColor(r, g, b, a); v++;
     v->setColor(r, g, b, a); v++;
     v->setColor(r, g, b, a); v++;
@@ -175,7 +241,7 @@ inline void VertexQueue::setTextureCoords(size_t index, float tx, float ty, floa
     auto v1 = v0 + th;
 
     auto ofs = index * 4;
-    auto v = vertices_.data() + ofs;
+    auto v = vertexData_ + ofs;
     v->setTexcoord(u0, v0); v++;
     v->setTexcoord(u1, v0); v++;
     v->setTexcoord(u1, v1); v++;
@@ -184,7 +250,7 @@ inline void VertexQueue::setTextureCoords(size_t index, float tx, float ty, floa
 
 inline void VertexQueue::setTextureMask(size_t index, uint32_t texture_mask) {
     auto ofs = index * 4;
-    auto v = vertices_.data() + ofs;
+    auto v = vertexData_ + ofs;
     v->setTexmask(texture_mask); v++;
     v->setTexmask(texture_mask); v++;
     v->setTexmask(texture_mask); v++;
@@ -193,7 +259,7 @@ inline void VertexQueue::setTextureMask(size_t index, uint32_t texture_mask) {
 
 inline void VertexQueue::setFlags(size_t index, uint32_t flags) {
     auto ofs = index * 4;
-    auto v = vertices_.data() + ofs;
+    auto v = vertexData_ + ofs;
     v->setFlags(flags); v++;
     v->setFlags(flags); v++;
     v->setFlags(flags); v++;
@@ -201,14 +267,15 @@ inline void VertexQueue::setFlags(size_t index, uint32_t flags) {
 }
 
 inline void VertexQueue::checkIndex(size_t& index) {
+    auto count = count_.load(std::memory_order_relaxed);
     if (index == npos) {
-        if (count_ + reserved_ >= capacity_) {
+        if (count + reserved_ >= capacity_) {
             throw std::runtime_error("vertex queue overflow");
         }
-        index = count_ + reserved_;
-        count_++;
+        index = count + reserved_;
+        count_.store(count + 1, std::memory_order_relaxed);
     } else {
-        if (index >= count_ + reserved_) {
+        if (index >= count + reserved_) {
             throw std::runtime_error("vertex queue index out of bounds");
         }
     }
@@ -236,14 +303,14 @@ void VertexQueue::set(const glm::vec4* optionalRect,
 // Quad Batch
 ///////////////////////////////////////////////////////////////////////////////
 
-QuadBatch QuadBatch::make(size_t capacity) {
+QuadBatch QuadBatch::make(size_t capacity, bool streaming) {
     QuadBatch quadBatch;
-    quadBatch.create(capacity);
+    quadBatch.create(capacity, streaming);
     return quadBatch;
 }
 
-void QuadBatch::create(size_t capacity) {
-    return VertexQueue::create(capacity);
+void QuadBatch::create(size_t capacity, bool streaming) {
+    return VertexQueue::create(capacity, streaming);
 }
 
 void QuadBatch::push(float x, float y, float w, float h,
@@ -251,12 +318,13 @@ void QuadBatch::push(float x, float y, float w, float h,
                      float tx, float ty, float tw, float th,
                      uint32_t texmask, uint32_t flags) {
 
-    if (count_ + reserved_ >= capacity_) {
+    auto count = count_.load(std::memory_order_relaxed);
+    if (count + reserved_ >= capacity_) {
         throw std::runtime_error("sprite batch overflow");
     }
 
-    auto index = count_ + reserved_;
-    count_++;
+    auto index = count + reserved_;
+    count_.store(count + 1, std::memory_order_relaxed);
 
     setCoords(index, x, y, w, h);
     setColor(index,  r, g, b, a);
@@ -267,6 +335,28 @@ void QuadBatch::push(float x, float y, float w, float h,
     modified_ = true;
 }
 
+bool QuadBatch::concurrentPush(float x, float y, float w, float h,
+                               float r, float g, float b, float a,
+                               float tx, float ty, float tw, float th,
+                               uint32_t texmask, uint32_t flags) {
+
+    // every caller claims its own slot, the vertices of different
+    // slots never overlap so no further synchronization is needed.
+    // the cursor may run past capacity, used() clamps it.
+    auto index = count_.fetch_add(1, std::memory_order_relaxed) + reserved_;
+    if (index >= capacity_) {
+        return false;
+    }
+
+    setCoords(index, x, y, w, h);
+    setColor(index,  r, g, b, a);
+    setTextureCoords(index, tx, ty, tw, th);
+    setTextureMask(index, texmask);
+    setFlags(index, flags);
+
+    return true;
+}
+
 void QuadBatch::push(const glm::vec4& rect) {
     set(&rect, &DEFAULT_COLOR, &DEFAULT_TEXTURE_COORDS, &DEFAULT_TEXTURE_MASK, &DEFAULT_FLAGS);
 }
@@ -286,7 +376,7 @@ void QuadBatch::store(size_t index,
                       uint32_t mask,
                       uint32_t flags) {
 
-    if (index >= count_ + reserved_) {
+    if (index >= used()) {
         throw std::runtime_error("sprite batch index out of bounds");
     }
 
@@ -316,14 +406,14 @@ void QuadBatch::store(size_t index,
 // Sprite Batch
 ///////////////////////////////////////////////////////////////////////////////
 
-SpriteBatch SpriteBatch::make(size_t capacity) {
+SpriteBatch SpriteBatch::make(size_t capacity, bool streaming) {
     SpriteBatch spriteBatch;
-    spriteBatch.create(capacity);
+    spriteBatch.create(capacity, streaming);
     return spriteBatch;
 }
 
-void SpriteBatch::create(size_t capacity) {
-    return VertexQueue::create(capacity);
+void SpriteBatch::create(size_t capacity, bool streaming) {
+    return VertexQueue::create(capacity, streaming);
 }
 
 void SpriteBatch::push(const Sprite& sprite) {
@@ -340,6 +430,12 @@ void SpriteBatch::set(const Sprite& sprite, size_t index) {
     auto texmask = sprite.textureMask();
     auto flags = sprite.flags();
 
+    if (nullptr != atlas_ && (size_t) sprite.frame() < atlas_->frameCount()) {
+        const auto& frame = atlas_->frame((size_t) sprite.frame());
+        texcoords = frame.texcoords;
+        texmask = 0x1u << frame.page;
+    }
+
     VertexQueue::set(
         &sprite.coords(),
         &sprite.color(),
@@ -348,4 +444,272 @@ void SpriteBatch::set(const Sprite& sprite, size_t index) {
         &flags,
         index
     );
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Quad Instance Batch
+///////////////////////////////////////////////////////////////////////////////
+
+QuadInstanceBatch QuadInstanceBatch::make(size_t capacity, bool streaming) {
+    QuadInstanceBatch batch;
+    batch.create(capacity, streaming);
+    return batch;
+}
+
+QuadInstanceBatch::QuadInstanceBatch(QuadInstanceBatch&& ref) {
+    *this = std::move(ref);
+}
+
+QuadInstanceBatch& QuadInstanceBatch::operator=(QuadInstanceBatch&& ref) {
+    capacity_ = ref.capacity_;
+    reserved_ = ref.reserved_;
+    count_.store(ref.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    modified_ = ref.modified_;
+    instanceData_ = ref.instanceData_;
+    instances_ = std::move(ref.instances_);
+    instanceBuffer_ = std::move(ref.instanceBuffer_);
+
+    ref.capacity_ = 0;
+    ref.reserved_ = 0;
+    ref.count_.store(0, std::memory_order_relaxed);
+    ref.instanceData_ = nullptr;
+
+    return *this;
+}
+
+void QuadInstanceBatch::create(size_t capacity, bool streaming) {
+
+    assert(capacity > 0);
+
+    capacity_ = capacity;
+    count_ = 0;
+    reserved_ = 0;
+    modified_ = false;
+
+    // one record per quad, the unit quad corners are generated
+    // from gl_VertexIndex in the vertex shader (no index buffer)
+
+    if (streaming) {
+        instances_.clear();
+        instanceBuffer_ = VertexBuffer::makeStreaming(capacity_ * sizeof(QuadInstance));
+        instanceData_ = static_cast<QuadInstance*>(instanceBuffer_.data(0));
+    } else {
+        instances_.resize(capacity_);
+        instanceBuffer_ = VertexBuffer::make(capacity_ * sizeof(QuadInstance));
+        instanceData_ = instances_.data();
+    }
+}
+
+void QuadInstanceBatch::begin() {
+    count_ = 0;
+
+    if (instanceBuffer_.isStreaming()) {
+        // see VertexQueue::begin()
+        const auto& frame = Device::globalInstance()->currentFrame();
+        frame.commandBuffersCompleted.wait();
+        instanceData_ = static_cast<QuadInstance*>(instanceBuffer_.data(frame.index));
+    }
+}
+
+void QuadInstanceBatch::end() {
+    // see VertexQueue::end()
+    if (count_.load(std::memory_order_acquire) > 0) {
+        modified_ = true;
+    }
+}
+
+void QuadInstanceBatch::clear() {
+    count_ = 0;
+    reserved_ = 0;
+}
+
+size_t QuadInstanceBatch::reserve(size_t numInstances) {
+
+    if (count_ > 0) {
+        throw std::runtime_error("cannot reserve after dynamic push to instance batch");
+    }
+
+    if (count_ + reserved_ + numInstances > capacity_) {
+        throw std::runtime_error("instance batch overflow");
+    }
+
+    size_t index = reserved_;
+
+    reserved_ += numInstances;
+
+    return index;
+}
+
+void QuadInstanceBatch::update() {
+
+    auto num = used();
+
+    if (!modified_ || 0 == num) {
+        return;
+    }
+
+    modified_ = false;
+
+    if (instanceBuffer_.isStreaming()) {
+        return; // host coherent memory, already visible to the gpu
+    }
+
+    instanceBuffer_.copy(instances_.data(), sizeof(QuadInstance) * num);
+}
+
+void QuadInstanceBatch::draw() {
+    update();
+
+    auto num = used();
+
+    if (0 == num) return;
+
+    auto device = Device::globalInstance();
+    instanceBuffer_.bind();
+    device->draw(6, 0, num);
+}
+
+void QuadInstanceBatch::submit(RenderQueue& queue, Material& material, uint32_t layer, float depth) {
+    update();
+
+    auto num = used();
+
+    if (0 == num) return;
+
+    DrawCommand command;
+    command.material = &material;
+    command.vertexBuffer = instanceBuffer_.handle();
+    command.count = 6;
+    command.instances = static_cast<uint32_t>(num);
+
+    queue.submit(command, layer, depth);
+}
+
+inline QuadInstance* QuadInstanceBatch::next() {
+    auto count = count_.load(std::memory_order_relaxed);
+    if (count + reserved_ >= capacity_) {
+        throw std::runtime_error("instance batch overflow");
+    }
+
+    auto index = count + reserved_;
+    count_.store(count + 1, std::memory_order_relaxed);
+    modified_ = true;
+
+    return instanceData_ + index;
+}
+
+inline QuadInstance* QuadInstanceBatch::nextConcurrent() {
+    // see QuadBatch::concurrentPush()
+    auto index = count_.fetch_add(1, std::memory_order_relaxed) + reserved_;
+    if (index >= capacity_) {
+        return nullptr;
+    }
+
+    return instanceData_ + index;
+}
+
+inline QuadInstance* QuadInstanceBatch::at(size_t index) {
+    if (index >= used()) {
+        throw std::runtime_error("instance batch index out of bounds");
+    }
+
+    modified_ = true;
+
+    return instanceData_ + index;
+}
+
+void QuadInstanceBatch::push(const glm::vec4& rect) {
+    push(rect, DEFAULT_COLOR, DEFAULT_TEXTURE_COORDS, DEFAULT_TEXTURE_MASK, DEFAULT_FLAGS);
+}
+
+void QuadInstanceBatch::push(const glm::vec4& rect,
+                             const glm::vec4& color,
+                             const glm::vec4& texcoords,
+                             uint32_t texmask,
+                             uint32_t flags) {
+    auto instance = next();
+    instance->setRect(rect);
+    instance->setColor(color);
+    instance->setTexcoords(texcoords);
+    instance->setTexmask(texmask);
+    instance->setFlags(flags);
+}
+
+void QuadInstanceBatch::push(float x, float y, float w, float h,
+                             float r, float g, float b, float a,
+                             float tx, float ty, float tw, float th,
+                             uint32_t texmask, uint32_t flags) {
+    next()->set(x, y, w, h, r, g, b, a, tx, ty, tw, th, texmask, flags);
+}
+
+bool QuadInstanceBatch::concurrentPush(const glm::vec4& rect,
+                                       const glm::vec4& color,
+                                       const glm::vec4& texcoords,
+                                       uint32_t texmask,
+                                       uint32_t flags) {
+    auto instance = nextConcurrent();
+    if (nullptr == instance) return false;
+
+    instance->setRect(rect);
+    instance->setColor(color);
+    instance->setTexcoords(texcoords);
+    instance->setTexmask(texmask);
+    instance->setFlags(flags);
+
+    return true;
+}
+
+bool QuadInstanceBatch::concurrentPush(float x, float y, float w, float h,
+                                       float r, float g, float b, float a,
+                                       float tx, float ty, float tw, float th,
+                                       uint32_t texmask, uint32_t flags) {
+    auto instance = nextConcurrent();
+    if (nullptr == instance) return false;
+
+    instance->set(x, y, w, h, r, g, b, a, tx, ty, tw, th, texmask, flags);
+
+    return true;
+}
+
+QuadInstance* QuadInstanceBatch::concurrentAppend(size_t numInstances, size_t& numAppended) {
+
+    // claims a whole range at once, the caller fills in exactly numAppended
+    // records. a range crossing the capacity is cut there, used() counts up
+    // to the capacity and every counted slot must be written.
+    auto index = count_.fetch_add(numInstances, std::memory_order_relaxed) + reserved_;
+    if (index >= capacity_) {
+        numAppended = 0;
+        return nullptr;
+    }
+
+    numAppended = std::min(numInstances, capacity_ - index);
+
+    return instanceData_ + index;
+}
+
+void QuadInstanceBatch::store(size_t index, const glm::vec4& rect) {
+    store(index, rect, DEFAULT_COLOR, DEFAULT_TEXTURE_COORDS, DEFAULT_TEXTURE_MASK, DEFAULT_FLAGS);
+}
+
+void QuadInstanceBatch::store(size_t index,
+                              const glm::vec4& rect,
+                              const glm::vec4& color,
+                              const glm::vec4& texcoords,
+                              uint32_t texmask,
+                              uint32_t flags) {
+    auto instance = at(index);
+    instance->setRect(rect);
+    instance->setColor(color);
+    instance->setTexcoords(texcoords);
+    instance->setTexmask(texmask);
+    instance->setFlags(flags);
+}
+
+void QuadInstanceBatch::store(size_t index,
+                              float x, float y, float w, float h,
+                              float r, float g, float b, float a,
+                              float tx, float ty, float tw, float th,
+                              uint32_t texmask,
+                              uint32_t flags) {
+    at(index)->set(x, y, w, h, r, g, b, a, tx, ty, tw, th, texmask, flags);
+}
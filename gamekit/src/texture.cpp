@@ -11,21 +11,21 @@
 
 using namespace gamekit;
 
-Texture Texture::make(const ResourceDescriptor& resourceDescriptor) {
+Texture Texture::make(const ResourceDescriptor& resourceDescriptor, const SamplerDescription& samplerDescription) {
     Texture texture;
-    texture.create(resourceDescriptor);
+    texture.create(resourceDescriptor, samplerDescription);
     return texture;
 }
 
-Texture Texture::make(const std::string& filename) {
+Texture Texture::make(const std::string& filename, const SamplerDescription& samplerDescription) {
     Texture texture;
-    texture.create(filename);
+    texture.create(filename, samplerDescription);
     return texture;
 }
 
-Texture Texture::make(const Image& image) {
+Texture Texture::make(const Image& image, const SamplerDescription& samplerDescription) {
     Texture texture;
-    texture.create(image);
+    texture.create(image, samplerDescription);
     return texture;
 }
 
@@ -35,7 +35,7 @@ Texture::Texture() {
 Texture::Texture(Texture&& ref) {
     image_ = std::move(ref.image_);
     imageView_ = std::move(ref.imageView_);
-    sampler_ = std::move(ref.sampler_);
+    sampler_ = ref.sampler_; ref.sampler_ = nullptr;
     width_ = ref.width_; ref.width_ = 0;
     height_ = ref.height_; ref.height_ = 0;
 }
@@ -49,7 +49,7 @@ Texture& Texture::operator=(Texture&& ref) {
 
     image_ = std::move(ref.image_);
     imageView_ = std::move(ref.imageView_);
-    sampler_ = std::move(ref.sampler_);
+    sampler_ = ref.sampler_; ref.sampler_ = nullptr;
     width_ = ref.width_; ref.width_ = 0;
     height_ = ref.height_; ref.height_ = 0;
 
@@ -60,26 +60,26 @@ Texture::~Texture() {
     free();
 }
 
-void Texture::create(const ResourceDescriptor& resourceDescriptor) {
+void Texture::create(const ResourceDescriptor& resourceDescriptor, const SamplerDescription& samplerDescription) {
     image_ = Image::make(resourceDescriptor);
     imageView_ = ImageView::make(image_);
-    sampler_ = Sampler::make();
+    sampler_ = &Device::globalInstance()->samplers().acquire(samplerDescription);
     width_ = image_.width();
     height_ = image_.height();
 }
 
-void Texture::create(const std::string& filename) {
+void Texture::create(const std::string& filename, const SamplerDescription& samplerDescription) {
     filename_ = filename;
     image_ = Image::make(filename);
     imageView_ = ImageView::make(image_);
-    sampler_ = Sampler::make();
+    sampler_ = &Device::globalInstance()->samplers().acquire(samplerDescription);
     width_ = image_.width();
     height_ = image_.height();
 }
 
-void Texture::create(const Image& image) {
+void Texture::create(const Image& image, const SamplerDescription& samplerDescription) {
     imageView_ = ImageView::make(image);
-    sampler_ = Sampler::make();
+    sampler_ = &Device::globalInstance()->samplers().acquire(samplerDescription);
     width_ = image.width();
     height_ = image.height();
 }
@@ -91,8 +91,8 @@ void Texture::free() {
 }
 
 void Texture::destroy() {
+    sampler_ = nullptr;
     if (!Device::globalInstance()) return;
-    sampler_.destroy();
     imageView_.destroy();
     image_.destroy();
 }
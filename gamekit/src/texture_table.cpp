@@ -0,0 +1,151 @@
+/*
+ * Texture Table
+ */
+
+#include <vulkan>
+
+#include "gamekit/texture_table.h"
+#include "gamekit/device.h"
+#include "gamekit/utilities.h"
+
+#include <stdexcept>
+#include <cassert>
+
+using namespace gamekit;
+
+void TextureTable::create(uint32_t capacity) {
+
+    destroy();
+
+    auto device = Device::globalHandle();
+    assert(nullptr != device);
+
+    capacity_ = (capacity < MAX_TEXTURES) ? capacity : MAX_TEXTURES;
+    if (capacity_ <= NO_TEXTURE + 1) {
+        throw std::runtime_error("texture table capacity too small");
+    }
+
+    // slots are written while the set is bound, and while command buffers
+    // of frames in flight use other slots
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = BINDING;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = capacity_;
+    binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+    binding.pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    auto res = vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, layout_.ref_ptr());
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create texture table layout: err={}", (int) res));
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes{ { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity_ } };
+    descriptorPool_ = DescriptorPool::make(poolSizes, 1, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+    descriptorSet_ = DescriptorSet::make(layout_.ptr(), descriptorPool_);
+
+    next_ = NO_TEXTURE + 1;
+}
+
+void TextureTable::destroy() {
+    indices_.clear();
+    free_.clear();
+    released_.clear();
+    descriptorSet_ = DescriptorSet{};
+    descriptorPool_.destroy();
+    layout_.free();
+    capacity_ = 0;
+}
+
+void TextureTable::update() {
+
+    for (auto it = released_.begin(); it != released_.end();) {
+        if (0 == --it->framesLeft) {
+            free_.push_back(it->index);
+            it = released_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+uint32_t TextureTable::add(const Texture& texture) {
+
+    assert(isValid());
+
+    auto it = indices_.find(&texture);
+    if (it != indices_.end()) return it->second;
+
+    uint32_t index = NO_TEXTURE;
+
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else if (next_ < capacity_) {
+        index = next_++;
+    } else {
+        throw std::runtime_error("texture table overflow");
+    }
+
+    write(index, texture);
+    indices_[&texture] = index;
+
+    return index;
+}
+
+void TextureTable::remove(const Texture& texture) {
+
+    auto it = indices_.find(&texture);
+    if (it == indices_.end()) return;
+
+    // frames in flight may still sample the slot, it is reused after they retired
+    released_.push_back({ it->second, Device::globalInstance()->frameCount() });
+    indices_.erase(it);
+}
+
+void TextureTable::refresh(const Texture& texture) {
+    auto it = indices_.find(&texture);
+    if (it != indices_.end()) {
+        write(it->second, texture);
+    }
+}
+
+uint32_t TextureTable::indexOf(const Texture& texture) const {
+    auto it = indices_.find(&texture);
+    return (it != indices_.end()) ? it->second : NO_TEXTURE;
+}
+
+void TextureTable::write(uint32_t index, const Texture& texture) {
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = texture.imageView();
+    imageInfo.sampler = texture.sampler();
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet_;
+    descriptorWrite.dstBinding = BINDING;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(Device::globalHandle(), 1, &descriptorWrite, 0, nullptr);
+}
@@ -0,0 +1,76 @@
+/*
+ * Thread Pool
+ */
+
+#include "gamekit/thread_pool.h"
+
+using namespace gamekit;
+
+ThreadPool::~ThreadPool() {
+    destroy();
+}
+
+void ThreadPool::create(size_t numThreads) {
+
+    destroy();
+
+    if (0 == numThreads) {
+        auto hardwareThreads = (size_t) std::thread::hardware_concurrency();
+        numThreads = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+    }
+
+    stopping_ = false;
+
+    threads_.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        threads_.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+void ThreadPool::destroy() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+
+    condition_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+
+    threads_.clear();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace_back(std::move(task));
+    }
+
+    condition_.notify_one();
+}
+
+void ThreadPool::run() {
+
+    for (;;) {
+
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+            if (tasks_.empty()) {
+                return; // stopping and drained
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,239 @@
+/*
+ * Transfer
+ */
+
+#include <vulkan>
+
+#include "gamekit/transfer.h"
+#include "gamekit/device.h"
+#include "gamekit/utilities.h"
+
+#include <stdexcept>
+#include <cassert>
+#include <algorithm>
+
+using namespace gamekit;
+
+///////////////////////////////////////////////////////////////////////////////
+// Transfer Batch
+///////////////////////////////////////////////////////////////////////////////
+
+void TransferBatch::destroy() {
+
+    if (submissions_.empty() && staging_.empty()) return;
+
+    for (const auto& submission : submissions_) {
+        if (submission.pending) {
+            submission.completed.wait();
+        }
+    }
+
+    staging_.clear();
+
+    for (auto& submission : submissions_) {
+        submission.commandBuffer.destroy();
+        submission.completed.destroy();
+    }
+
+    submissions_.clear();
+    recording_ = npos;
+}
+
+VkCommandBuffer TransferBatch::begin() {
+
+    if (npos != recording_) {
+        return submissions_[recording_].commandBuffer;
+    }
+
+    collect();
+
+    size_t slot = npos;
+    for (size_t i = 0; i < submissions_.size(); i++) {
+        if (!submissions_[i].pending) {
+            slot = i;
+            break;
+        }
+    }
+
+    if (npos == slot) {
+        slot = submissions_.size();
+        auto& submission = submissions_.emplace_back();
+        submission.commandBuffer = CommandBuffer::make();
+        submission.completed = Fence::make(false);
+    }
+
+    auto& submission = submissions_[slot];
+    submission.commandBuffer.reset();
+
+    VkCommandBuffer commandBuffer = submission.commandBuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    auto res = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to begin transfer command buffer: err={}", (int) res));
+    }
+
+    // transfers must not overwrite data still used by previously submitted frames
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         1, &barrier,
+                         0, nullptr,
+                         0, nullptr);
+
+    recording_ = slot;
+
+    return commandBuffer;
+}
+
+void TransferBatch::submit() {
+
+    if (npos == recording_) return;
+
+    auto& submission = submissions_[recording_];
+    VkCommandBuffer commandBuffer = submission.commandBuffer;
+
+    // make the transferred data visible to everything submitted afterwards
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0,
+                         1, &barrier,
+                         0, nullptr,
+                         0, nullptr);
+
+    auto res = vkEndCommandBuffer(commandBuffer);
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to record transfer command buffer: err={}", (int) res));
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    auto graphicsQueue = Device::globalInstance()->graphicsQueue();
+    assert(nullptr != graphicsQueue);
+
+    res = vkQueueSubmit(graphicsQueue, 1, &submitInfo, submission.completed);
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to submit transfer command buffer: err={}", (int) res));
+    }
+
+    submission.pending = true;
+    recording_ = npos;
+}
+
+void TransferBatch::flush() {
+
+    submit();
+
+    for (const auto& submission : submissions_) {
+        if (submission.pending) {
+            submission.completed.wait();
+        }
+    }
+
+    collect();
+}
+
+void TransferBatch::collect() {
+
+    for (size_t i = 0; i < submissions_.size(); i++) {
+        auto& submission = submissions_[i];
+        if (!submission.pending) continue;
+        if (VK_SUCCESS != submission.completed.status()) continue;
+
+        submission.completed.reset();
+        submission.pending = false;
+        releaseStaging(i);
+    }
+
+    trimStaging();
+}
+
+bool TransferBatch::isPending() const {
+    for (const auto& submission : submissions_) {
+        if (submission.pending) return true;
+    }
+    return false;
+}
+
+BufferObject& TransferBatch::stagingBuffer(size_t size) {
+
+    begin(); // staging memory is owned by the recording submission
+
+    StagingBuffer* bestFit = nullptr;
+    for (auto& staging : staging_) {
+        if (npos != staging->owner) continue;
+        if (staging->buffer.size() < size) continue;
+        if (nullptr == bestFit || staging->buffer.size() < bestFit->buffer.size()) {
+            bestFit = staging.get();
+        }
+    }
+
+    if (nullptr == bestFit) {
+        size_t allocSize = MIN_STAGING_SIZE;
+        while (allocSize < size) allocSize *= 2;
+
+        auto& staging = staging_.emplace_back(std::make_unique<StagingBuffer>());
+        staging->buffer = BufferObject::make(
+            BufferType::StagingBuffer,
+            allocSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory);
+        staging->buffer.mapPersistent();
+
+        bestFit = staging.get();
+    }
+
+    bestFit->owner = recording_;
+
+    return bestFit->buffer;
+}
+
+void TransferBatch::releaseStaging(size_t owner) {
+    for (auto& staging : staging_) {
+        if (owner == staging->owner) {
+            staging->owner = npos;
+        }
+    }
+}
+
+void TransferBatch::trimStaging() {
+
+    // keep a bounded amount of idle staging memory for reuse, large loads
+    // must not pin their peak staging size for the rest of the session
+
+    size_t idleSize = 0;
+    for (const auto& staging : staging_) {
+        if (npos == staging->owner) idleSize += staging->buffer.size();
+    }
+
+    if (idleSize <= MAX_STAGING_POOL_SIZE) return;
+
+    std::stable_sort(staging_.begin(), staging_.end(), [](const auto& a, const auto& b) {
+        return a->buffer.size() > b->buffer.size();
+    });
+
+    for (auto it = staging_.begin(); it != staging_.end() && idleSize > MAX_STAGING_POOL_SIZE; ) {
+        if (npos == (*it)->owner) {
+            idleSize -= (*it)->buffer.size();
+            it = staging_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -9,6 +9,9 @@
 #include "gamekit/utilities.h"
 
 #include <fstream>
+#include <algorithm>
+#include <functional>
+#include <cstring>
 #include <stdexcept>
 #include <utility>
 
@@ -85,6 +88,11 @@ VkResult Fence::reset() const {
     return vkResetFences(device, 1, handle_.ref_ptr());
 }
 
+VkResult Fence::status() const {
+    auto device = Device::globalHandle();
+    return vkGetFenceStatus(device, handle_.ptr());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Command Buffer
 ///////////////////////////////////////////////////////////////////////////////
@@ -146,6 +154,8 @@ Shader Shader::make(const ResourceDescriptor& resourceDescriptor) {
         shaderType = ShaderType::VertexShader;
     } else if (resourceDescriptor.type == ResourceType::FragmentShader) {
         shaderType = ShaderType::FragmentShader;
+    } else if (resourceDescriptor.type == ResourceType::ComputeShader) {
+        shaderType = ShaderType::ComputeShader;
     } else {
         throw std::runtime_error("unsupported resource type for shader");
     }
@@ -214,70 +224,65 @@ void ShaderRegistry::registerShader(const ShaderDescriptor& shaderDescriptor) {
 // Device Memory
 ///////////////////////////////////////////////////////////////////////////////
 
-DeviceMemory DeviceMemory::make(size_t size, uint32_t typeFilter, uint32_t flags) {
+DeviceMemory DeviceMemory::make(const VkMemoryRequirements& requirements, uint32_t flags, bool linear) {
 
     VkMemoryPropertyFlags propertyFlags = 0x0;
     if (0x0 != (flags & Flags::DeviceLocalMemory))  propertyFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
     if (0x0 != (flags & Flags::HostCoherentMemory)) propertyFlags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     if (0x0 != (flags & Flags::HostVisibleMemory))  propertyFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
-    auto physicalDevice = Device::globalInstance()->physicalDevice();
-    assert(nullptr != physicalDevice);
+    auto deviceObj = Device::globalInstance();
+    assert(nullptr != deviceObj);
 
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    DeviceMemory object;
 
-    uint32_t typeIndex = 0;
-    bool found = false;
+    object.typeFilter_ = requirements.memoryTypeBits;
+    object.flags_ = flags;
+    object.allocation_ = deviceObj->allocator().alloc(requirements, propertyFlags, linear);
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-         if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags) {
-            typeIndex = i;
-            found = true;
-            break;
-        }
-    }
+    return object;
+}
+
+DeviceMemory::DeviceMemory(DeviceMemory&& ref) {
+    allocation_ = ref.allocation_; ref.allocation_ = {};
+    flags_ = ref.flags_; ref.flags_ = None;
+    typeFilter_ = ref.typeFilter_; ref.typeFilter_ = 0;
+}
 
-    if (!found) {
-        throw std::runtime_error("failed to find suitable memory type!");
+DeviceMemory& DeviceMemory::operator=(DeviceMemory&& ref) {
+    if (this == &ref) {
+        return *this;
     }
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = size;
-    allocInfo.memoryTypeIndex = typeIndex;
+    destroy();
 
-    auto device = Device::globalHandle();
+    allocation_ = ref.allocation_; ref.allocation_ = {};
+    flags_ = ref.flags_; ref.flags_ = None;
+    typeFilter_ = ref.typeFilter_; ref.typeFilter_ = 0;
 
-    DeviceMemory object;
+    return *this;
+}
 
-    object.size_ = size;
-    object.typeFilter_ = typeFilter;
-    object.flags_ = flags;
+void DeviceMemory::destroy() {
+    if (nullptr == allocation_.memory) return;
 
-    auto res = vkAllocateMemory(device, &allocInfo, nullptr, object.handle_.ref_ptr());
-    if (VK_SUCCESS != res) {
-        throw std::runtime_error(Format::str("Failed to allocate vertex buffer memory: err={}", (int) res));
+    auto deviceObj = Device::globalInstance();
+    if (nullptr != deviceObj) {
+        deviceObj->allocator().free(allocation_);
     }
 
-    return object;
-}
-
-template <> void Reference<VkDeviceMemory>::destroy() {
-    auto device = Device::globalHandle();
-    vkFreeMemory(device, handle_, nullptr);
+    allocation_ = {};
 }
 
 void* DeviceMemory::map(size_t ofs, size_t len) const {
-    auto device = Device::globalHandle();
-    void* ptr{nullptr};
-    vkMapMemory(device, handle_.ptr(), ofs, len, 0, &ptr);
-    return ptr;
+    // host visible memory is persistently mapped by the allocator
+    if (nullptr == allocation_.mapped) return nullptr;
+    assert(ofs + len <= allocation_.size);
+    return static_cast<uint8_t*>(allocation_.mapped) + ofs;
 }
 
 void DeviceMemory::unmap() const {
-    auto device = Device::globalHandle();
-    vkUnmapMemory(device, handle_.ptr());
+    // nothing to do, mapping lifetime is managed by the allocator
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -286,22 +291,28 @@ void DeviceMemory::unmap() const {
 
 DescriptorPool DescriptorPool::make(size_t size) {
 
-    auto device = Device::globalHandle();
-    assert(nullptr != device);
-
     VkDescriptorPoolSize poolSize{};
     poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     poolSize.descriptorCount = static_cast<uint32_t>(size);
 
+    return make(std::vector<VkDescriptorPoolSize>{ poolSize }, size);
+}
+
+DescriptorPool DescriptorPool::make(const std::vector<VkDescriptorPoolSize>& poolSizes, size_t maxSets, VkDescriptorPoolCreateFlags flags) {
+
+    auto device = Device::globalHandle();
+    assert(nullptr != device);
+
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
-    poolInfo.maxSets = static_cast<uint32_t>(size);
+    poolInfo.flags = flags;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = static_cast<uint32_t>(maxSets);
 
     DescriptorPool object;
 
-    object.size_ = size;
+    object.size_ = maxSets;
 
     auto res = vkCreateDescriptorPool(device, &poolInfo, nullptr, object.handle_.ref_ptr());
     if (VK_SUCCESS != res) {
@@ -316,6 +327,37 @@ template <> void Reference<VkDescriptorPool>::destroy() {
     vkDestroyDescriptorPool(device, handle_, nullptr);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Query Pool
+///////////////////////////////////////////////////////////////////////////////
+
+QueryPool QueryPool::make(size_t size) {
+
+    auto device = Device::globalHandle();
+    assert(nullptr != device);
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = static_cast<uint32_t>(size);
+
+    QueryPool object;
+
+    object.size_ = size;
+
+    auto res = vkCreateQueryPool(device, &poolInfo, nullptr, object.handle_.ref_ptr());
+    if (VK_SUCCESS != res) {
+        throw std::runtime_error(Format::str("Failed to create query pool: err={}", (int) res));
+    }
+
+    return object;
+}
+
+template <> void Reference<VkQueryPool>::destroy() {
+    auto device = Device::globalHandle();
+    vkDestroyQueryPool(device, handle_, nullptr);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Descriptor Set
 ///////////////////////////////////////////////////////////////////////////////
@@ -347,23 +389,123 @@ template <> void Reference<VkDescriptorSet>::destroy() {}
 // Image
 ///////////////////////////////////////////////////////////////////////////////
 
-Image Image::make(const ResourceDescriptor& resourceDescriptor) {
+// texture container written by gamekitc, see tools/texenc.py
+static const uint8_t TEXTURE_MAGIC[12] = { 0xab, 'G', 'K', 'T', ' ', '1', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+static const uint32_t MAX_TEXTURE_LEVELS = 16;
+
+#pragma pack(push, 1)
+struct TextureHeader {
+    uint8_t magic[12];
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+};
+
+struct TextureLevel {
+    uint64_t offset;
+    uint64_t size;
+};
+#pragma pack(pop)
+
+static void decodeColorBlock(const uint8_t* block, uint8_t* rgba, bool allowTransparent) {
+
+    auto c0 = (uint32_t) (block[0] | (block[1] << 8));
+    auto c1 = (uint32_t) (block[2] | (block[3] << 8));
+    auto indices = (uint32_t) (block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t) block[7] << 24));
+
+    uint8_t palette[4][3];
+
+    auto expand = [](uint32_t c, uint8_t* rgb) {
+        auto r = (c >> 11) & 0x1f;
+        auto g = (c >> 5) & 0x3f;
+        auto b = c & 0x1f;
+        rgb[0] = (uint8_t) ((r << 3) | (r >> 2));
+        rgb[1] = (uint8_t) ((g << 2) | (g >> 4));
+        rgb[2] = (uint8_t) ((b << 3) | (b >> 2));
+    };
 
-    int imageWidth = 0;
-    int imageHeight = 0;
-    int imageChannels = 0;
+    expand(c0, palette[0]);
+    expand(c1, palette[1]);
+
+    // three color mode only exists in BC1, index 3 is black
+    auto threeColors = allowTransparent && c0 <= c1;
+
+    for (int c = 0; c < 3; c++) {
+        auto a = (uint32_t) palette[0][c];
+        auto b = (uint32_t) palette[1][c];
+        if (threeColors) {
+            palette[2][c] = (uint8_t) ((a + b + 1) / 2);
+            palette[3][c] = 0;
+        } else {
+            palette[2][c] = (uint8_t) ((2 * a + b + 1) / 3);
+            palette[3][c] = (uint8_t) ((a + 2 * b + 1) / 3);
+        }
+    }
 
-    auto pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(resourceDescriptor.data), (int) resourceDescriptor.dataSize, &imageWidth, &imageHeight, &imageChannels, STBI_rgb_alpha);
-    if (nullptr == pixels) {
-        throw std::runtime_error("failed to load image from file!");
+    for (int i = 0; i < 16; i++) {
+        const auto* color = palette[(indices >> (i * 2)) & 0x3];
+        rgba[i * 4 + 0] = color[0];
+        rgba[i * 4 + 1] = color[1];
+        rgba[i * 4 + 2] = color[2];
     }
+}
 
-    Image object;
-    object.createImage(pixels, imageWidth, imageHeight, imageChannels, VK_FORMAT_R8G8B8A8_SRGB);
-    stbi_image_free(pixels);
-    pixels = nullptr;
+static void decodeAlphaBlock(const uint8_t* block, uint8_t* rgba) {
 
-    return object;
+    auto a0 = (uint32_t) block[0];
+    auto a1 = (uint32_t) block[1];
+
+    uint8_t palette[8];
+    palette[0] = (uint8_t) a0;
+    palette[1] = (uint8_t) a1;
+
+    if (a0 > a1) {
+        for (uint32_t i = 1; i < 7; i++) palette[i + 1] = (uint8_t) (((7 - i) * a0 + i * a1 + 3) / 7);
+    } else {
+        for (uint32_t i = 1; i < 5; i++) palette[i + 1] = (uint8_t) (((5 - i) * a0 + i * a1 + 2) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++) indices |= (uint64_t) block[2 + i] << (i * 8);
+
+    for (int i = 0; i < 16; i++) {
+        rgba[i * 4 + 3] = palette[(indices >> (i * 3)) & 0x7];
+    }
+}
+
+// cpu fallback for devices without BC support
+static void decodeBlocks(const uint8_t* data, uint32_t width, uint32_t height, bool alpha, uint8_t* pixels) {
+
+    uint8_t block[16 * 4];
+    auto blockSize = alpha ? 16 : 8;
+
+    for (uint32_t by = 0; by < height; by += 4) {
+        for (uint32_t bx = 0; bx < width; bx += 4) {
+
+            if (alpha) {
+                decodeAlphaBlock(data, block);
+                decodeColorBlock(data + 8, block, false);
+            } else {
+                for (int i = 0; i < 16; i++) block[i * 4 + 3] = 0xff;
+                decodeColorBlock(data, block, true);
+            }
+
+            data += blockSize;
+
+            auto w = std::min(4u, width - bx);
+            auto h = std::min(4u, height - by);
+            for (uint32_t y = 0; y < h; y++) {
+                std::memcpy(pixels + ((size_t) (by + y) * width + bx) * 4, block + y * 16, (size_t) w * 4);
+            }
+        }
+    }
+}
+
+Image Image::make(const ResourceDescriptor& resourceDescriptor) {
+    return make(decode(resourceDescriptor));
 }
 
 Image Image::make(const std::string& filename) {
@@ -377,10 +519,13 @@ Image Image::make(const std::string& filename) {
         throw std::runtime_error("failed to load image from file!");
     }
 
+    return make(decodePixels(pixels, imageWidth, imageHeight));
+}
+
+Image Image::make(const Source& source) {
+
     Image object;
-    object.createImage(pixels, imageWidth, imageHeight, imageChannels, VK_FORMAT_R8G8B8A8_SRGB);
-    stbi_image_free(pixels);
-    pixels = nullptr;
+    object.createImage(source.data, source.dataSize, source.levels, source.format, source.generateMips);
 
     return object;
 }
@@ -419,31 +564,164 @@ Image Image::attach(VkImage image, ImageType imageType, VkFormat format) {
     return object;
 }
 
-void Image::createImage(const void* pixels, int width, int height, int channels, VkFormat format) {
+void Image::createImage(const void* data, size_t dataSize, const std::vector<Level>& levels, VkFormat format, bool generateMips) {
 
     auto device = Device::globalHandle();
     assert(nullptr != device);
+    assert(!levels.empty());
+
+    auto width = levels[0].width;
+    auto height = levels[0].height;
+    auto mipLevels = static_cast<uint32_t>(levels.size());
 
-    auto imageSize = static_cast<size_t>(width * height * 4);
+    if (generateMips && 1 == mipLevels) {
+        // blitting with a linear filter needs format support
+        VkFormatProperties formatProperties{};
+        vkGetPhysicalDeviceFormatProperties(Device::globalInstance()->physicalDevice(), format, &formatProperties);
+
+        const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                                  VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                                  VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+        if (blitFeatures == (formatProperties.optimalTilingFeatures & blitFeatures)) {
+            while ((std::max(width, height) >> mipLevels) > 0) mipLevels++;
+        }
+    }
 
-    auto stagingBuffer = BufferObject::make(
-        BufferType::StagingBuffer,
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        DeviceMemory::HostVisibleMemory | DeviceMemory::HostCoherentMemory);
+    // staging memory is recycled by the transfer batch once the upload completed
+    auto& stagingBuffer = Device::globalInstance()->transfers().stagingBuffer(dataSize);
+    stagingBuffer.copy(data, dataSize);
 
-    stagingBuffer.copy(pixels);
+    createImage(ImageType::PixelBuffer, (int) width, (int) height, format, mipLevels);
+    size_ = dataSize;
 
-    createImage(ImageType::PixelBuffer, width, height, format);
     transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(stagingBuffer.ptr(), static_cast<uint32_t>(width), static_cast<uint32_t>(height));
-    transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    copyBufferToImage(stagingBuffer.ptr(), levels);
+
+    if (mipLevels > levels.size()) {
+        generateMipmaps();
+    } else {
+        transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+}
+
+Image::Source Image::decodeCompressed(const ResourceDescriptor& resourceDescriptor) {
 
-    stagingBuffer.destroy();
+    auto data = static_cast<const uint8_t*>(resourceDescriptor.data);
+    auto dataSize = resourceDescriptor.dataSize;
 
+    TextureHeader header{};
+    if (dataSize < sizeof(header)) {
+        throw std::runtime_error("invalid texture container");
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+
+    auto format = static_cast<VkFormat>(header.format);
+    auto alpha = (VK_FORMAT_BC3_SRGB_BLOCK == format);
+
+    if (0 != std::memcmp(header.magic, TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC)) ||
+        (!alpha && VK_FORMAT_BC1_RGB_SRGB_BLOCK != format) ||
+        0 == header.width || 0 == header.height ||
+        0 == header.levelCount || header.levelCount > MAX_TEXTURE_LEVELS ||
+        dataSize < sizeof(header) + header.levelCount * sizeof(TextureLevel)) {
+        throw std::runtime_error("invalid texture container");
+    }
+
+    size_t blockSize = alpha ? 16 : 8;
+
+    // levels are stored back to back, uploaded with one staging copy
+    std::vector<Level> levels(header.levelCount);
+    std::vector<TextureLevel> entries(header.levelCount);
+    std::memcpy(entries.data(), data + sizeof(header), entries.size() * sizeof(TextureLevel));
+
+    size_t compressedSize = 0;
+    size_t decodedSize = 0;
+
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        auto& level = levels[i];
+        level.width = std::max(1u, header.width >> i);
+        level.height = std::max(1u, header.height >> i);
+
+        auto numBlocks = (size_t) ((level.width + 3) / 4) * (size_t) ((level.height + 3) / 4);
+        const auto& entry = entries[i];
+
+        if (entry.offset != entries[0].offset + compressedSize ||
+            entry.size < numBlocks * blockSize ||
+            entry.offset + entry.size > dataSize) {
+            throw std::runtime_error("invalid texture container");
+        }
+
+        level.offset = compressedSize;
+        compressedSize += (size_t) entry.size;
+        decodedSize += (size_t) level.width * level.height * 4;
+    }
+
+    VkFormatProperties formatProperties{};
+    vkGetPhysicalDeviceFormatProperties(Device::globalInstance()->physicalDevice(), format, &formatProperties);
+
+    Source source;
+    source.levels = std::move(levels);
+
+    if (0 != (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        source.data = data + entries[0].offset;
+        source.dataSize = compressedSize;
+        source.format = format;
+        return source;
+    }
+
+    // no BC support, decode to rgba
+    std::shared_ptr<uint8_t> pixels(new uint8_t[decodedSize], std::default_delete<uint8_t[]>());
+    size_t offset = 0;
+
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        auto& level = source.levels[i];
+        decodeBlocks(data + entries[i].offset, level.width, level.height, alpha, pixels.get() + offset);
+        level.offset = offset;
+        offset += (size_t) level.width * level.height * 4;
+    }
+
+    source.data = pixels.get();
+    source.dataSize = decodedSize;
+    source.storage = std::move(pixels);
+    source.format = VK_FORMAT_R8G8B8A8_SRGB;
+
+    return source;
 }
 
-void Image::createImage(ImageType imageType, int width, int height, VkFormat format) {
+Image::Source Image::decode(const ResourceDescriptor& resourceDescriptor) {
+
+    if (ResourceType::CompressedBitmap == resourceDescriptor.type) {
+        return decodeCompressed(resourceDescriptor);
+    }
+
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int imageChannels = 0;
+
+    auto pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(resourceDescriptor.data), (int) resourceDescriptor.dataSize, &imageWidth, &imageHeight, &imageChannels, STBI_rgb_alpha);
+    if (nullptr == pixels) {
+        throw std::runtime_error("failed to load image from file!");
+    }
+
+    return decodePixels(pixels, imageWidth, imageHeight);
+}
+
+Image::Source Image::decodePixels(const uint8_t* pixels, int width, int height) {
+
+    // takes ownership of the stb allocation
+    Source source;
+    source.storage = std::shared_ptr<const uint8_t>(pixels, [](const uint8_t* ptr) { stbi_image_free(const_cast<uint8_t*>(ptr)); });
+    source.data = pixels;
+    source.dataSize = static_cast<size_t>(width * height * 4);
+    source.levels = { { 0, static_cast<uint32_t>(width), static_cast<uint32_t>(height) } };
+    source.format = VK_FORMAT_R8G8B8A8_SRGB;
+    source.generateMips = true;
+
+    return source;
+}
+
+void Image::createImage(ImageType imageType, int width, int height, VkFormat format, uint32_t mipLevels) {
 
     imageType_ = imageType;
     width_ = width;
@@ -451,6 +729,7 @@ void Image::createImage(ImageType imageType, int width, int height, VkFormat for
     format_ = format;
     channels_ = 4;
     size_ = static_cast<size_t>(width * height * 4);
+    mipLevels_ = mipLevels;
 
     auto device = Device::globalHandle();
     assert(nullptr != device);
@@ -459,8 +738,11 @@ void Image::createImage(ImageType imageType, int width, int height, VkFormat for
 
     if (ImageType::DepthBuffer == imageType) {
         usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    } else if (ImageType::RenderTarget == imageType) {
+        usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
     } else {
-        usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        // transfer source for mip generation
+        usageFlags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     }
 
     VkImageCreateInfo imageInfo{};
@@ -469,7 +751,7 @@ void Image::createImage(ImageType imageType, int width, int height, VkFormat for
     imageInfo.extent.width = static_cast<uint32_t>(width);
     imageInfo.extent.height = static_cast<uint32_t>(height);
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels_;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -487,11 +769,9 @@ void Image::createImage(ImageType imageType, int width, int height, VkFormat for
     VkMemoryRequirements memRequirements{};
     vkGetImageMemoryRequirements(device, handle_.ptr(), &memRequirements);
 
-    memory_ = DeviceMemory::make(memRequirements.size,
-                                 memRequirements.memoryTypeBits,
-                                 DeviceMemory::DeviceLocalMemory);
+    memory_ = DeviceMemory::make(memRequirements, DeviceMemory::DeviceLocalMemory, false);
 
-    res = vkBindImageMemory(device, handle_.ptr(), memory_.ptr(), 0);
+    res = vkBindImageMemory(device, handle_.ptr(), memory_.ptr(), memory_.offset());
     if (VK_SUCCESS != res) {
         throw std::runtime_error(Format::str("Failed to bind image memory: err={}", (int) res));
     }
@@ -513,7 +793,7 @@ void Image::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayo
     barrier.image = handle_.ptr();
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = mipLevels_;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
 
@@ -548,25 +828,111 @@ void Image::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayo
     device->endCommand(commandBuffer);
 }
 
-void Image::copyBufferToImage(VkBuffer buffer, uint32_t width, uint32_t height) {
+void Image::copyBufferToImage(VkBuffer buffer, const std::vector<Level>& levels) {
+
+    auto device = Device::globalInstance();
+    assert(nullptr != device);
+
+    VkCommandBuffer commandBuffer = device->beginCommand();
+
+    std::vector<VkBufferImageCopy> regions(levels.size());
+
+    for (size_t i = 0; i < levels.size(); i++) {
+        auto& region = regions[i];
+        region.bufferOffset = levels[i].offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = static_cast<uint32_t>(i);
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {levels[i].width, levels[i].height, 1};
+    }
+
+    vkCmdCopyBufferToImage(commandBuffer, buffer, handle_.ptr(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+    device->endCommand(commandBuffer);
+}
+
+void Image::generateMipmaps() {
 
     auto device = Device::globalInstance();
     assert(nullptr != device);
 
     VkCommandBuffer commandBuffer = device->beginCommand();
 
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {width, height, 1};
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = handle_.ptr();
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    auto levelWidth = static_cast<int32_t>(width_);
+    auto levelHeight = static_cast<int32_t>(height_);
+
+    for (uint32_t level = 1; level < mipLevels_; level++) {
+
+        // previous level was written by the copy or the last blit
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        auto nextWidth = std::max(1, levelWidth / 2);
+        auto nextHeight = std::max(1, levelHeight / 2);
+
+        VkImageBlit blit{};
+        blit.srcOffsets[0] = {0, 0, 0};
+        blit.srcOffsets[1] = {levelWidth, levelHeight, 1};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[0] = {0, 0, 0};
+        blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+
+        vkCmdBlitImage(commandBuffer,
+                       handle_.ptr(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       handle_.ptr(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blit, VK_FILTER_LINEAR);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-    vkCmdCopyBufferToImage(commandBuffer, buffer, handle_.ptr(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    // the last level is only written to
+    barrier.subresourceRange.baseMipLevel = mipLevels_ - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &barrier);
 
     device->endCommand(commandBuffer);
 }
@@ -600,7 +966,7 @@ ImageView ImageView::make(const Image& image) {
     createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
     createInfo.subresourceRange.aspectMask = aspectMask;
     createInfo.subresourceRange.baseMipLevel = 0;
-    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.levelCount = image.mipLevels();
     createInfo.subresourceRange.baseArrayLayer = 0;
     createInfo.subresourceRange.layerCount = 1;
 
@@ -672,7 +1038,28 @@ template <> void Reference<VkFramebuffer>::destroy() {
 // Sampler
 ///////////////////////////////////////////////////////////////////////////////
 
+size_t SamplerDescription::hash() const {
+
+    size_t seed = 0;
+
+    auto combine = [&seed](size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    };
+
+    combine((size_t) magFilter);
+    combine((size_t) minFilter);
+    combine((size_t) mipmapMode);
+    combine((size_t) addressMode);
+    combine(std::hash<float>{}(maxAnisotropy));
+
+    return seed;
+}
+
 Sampler Sampler::make() {
+    return make(SamplerDescription{});
+}
+
+Sampler Sampler::make(const SamplerDescription& description) {
 
     auto device = Device::globalHandle();
     assert(nullptr != device);
@@ -680,20 +1067,24 @@ Sampler Sampler::make() {
     VkPhysicalDeviceProperties properties{};
     vkGetPhysicalDeviceProperties(Device::globalInstance()->physicalDevice(), &properties);
 
+    auto maxAnisotropy = std::min(description.maxAnisotropy, properties.limits.maxSamplerAnisotropy);
+
     VkSamplerCreateInfo samplerInfo{};
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+    samplerInfo.magFilter = description.magFilter;
+    samplerInfo.minFilter = description.minFilter;
+    samplerInfo.addressModeU = description.addressMode;
+    samplerInfo.addressModeV = description.addressMode;
+    samplerInfo.addressModeW = description.addressMode;
+    samplerInfo.anisotropyEnable = (maxAnisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy = std::max(maxAnisotropy, 1.0f);
     samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipmapMode = description.mipmapMode;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;    // all levels of the image view
 
     Sampler object;
 
@@ -710,6 +1101,41 @@ template <> void Reference<VkSampler>::destroy() {
     vkDestroySampler(device, handle_, nullptr);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Sampler Cache
+///////////////////////////////////////////////////////////////////////////////
+
+const Sampler& SamplerCache::acquire(const SamplerDescription& description) {
+
+    auto hash = description.hash();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto range = samplers_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->description == description) {
+            return it->second->sampler;
+        }
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->description = description;
+    entry->sampler = Sampler::make(description);
+
+    auto it = samplers_.emplace(hash, std::move(entry));
+    return it->second->sampler;
+}
+
+void SamplerCache::destroy() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    samplers_.clear();
+}
+
+size_t SamplerCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samplers_.size();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Others
 ///////////////////////////////////////////////////////////////////////////////
@@ -74,5 +74,13 @@ const std::string& Environment::getBasePath() {
 }
 
 std::string Environment::getPrefPath(const std::string& org, const std::string& app) {
-    return SDL_GetPrefPath(org.c_str(), app.c_str());
+    auto path = SDL_GetPrefPath(org.c_str(), app.c_str());
+    if (nullptr == path) {
+        return std::string(); // no writable location
+    }
+
+    std::string prefPath(path);
+    SDL_free(path);
+
+    return prefPath;
 }
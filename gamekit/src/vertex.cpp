@@ -53,3 +53,49 @@ std::array<VkVertexInputAttributeDescription, Vertex::NUM_ATTRIBUTES> Vertex::ge
 
     return attributeDescriptions;
 }
+
+VkVertexInputBindingDescription QuadInstance::getBindingDescription() {
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(QuadInstance);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, QuadInstance::NUM_ATTRIBUTES> QuadInstance::getAttributeDescriptions() {
+    std::array<VkVertexInputAttributeDescription, QuadInstance::NUM_ATTRIBUTES> attributeDescriptions{};
+
+    int idx = 0;
+
+    attributeDescriptions[idx].binding = 0;
+    attributeDescriptions[idx].location = idx;
+    attributeDescriptions[idx].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attributeDescriptions[idx].offset = offsetof(QuadInstance, rect_);
+    idx++;
+
+    attributeDescriptions[idx].binding = 0;
+    attributeDescriptions[idx].location = idx;
+    attributeDescriptions[idx].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attributeDescriptions[idx].offset = offsetof(QuadInstance, texcoords_);
+    idx++;
+
+    attributeDescriptions[idx].binding = 0;
+    attributeDescriptions[idx].location = idx;
+    attributeDescriptions[idx].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attributeDescriptions[idx].offset = offsetof(QuadInstance, color_);
+    idx++;
+
+    attributeDescriptions[idx].binding = 0;
+    attributeDescriptions[idx].location = idx;
+    attributeDescriptions[idx].format = VK_FORMAT_R32_UINT;
+    attributeDescriptions[idx].offset = offsetof(QuadInstance, texmask_);
+    idx++;
+
+    attributeDescriptions[idx].binding = 0;
+    attributeDescriptions[idx].location = idx;
+    attributeDescriptions[idx].format = VK_FORMAT_R32_UINT;
+    attributeDescriptions[idx].offset = offsetof(QuadInstance, flags_);
+    idx++;
+
+    return attributeDescriptions;
+}
@@ -0,0 +1,190 @@
+/*
+ * Watcher
+ */
+
+#include "gamekit/watcher.h"
+#include "gamekit/clock.h"
+#include "gamekit/utilities.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace gamekit;
+
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+// editors either rewrite the file or rename a temporary over it
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+#endif
+
+static void addChange(std::vector<std::string>& changes, std::string filename) {
+    if (std::find(changes.begin(), changes.end(), filename) == changes.end()) {
+        changes.emplace_back(std::move(filename));
+    }
+}
+
+FileWatcher::FileWatcher(FileWatcher&& other) noexcept {
+    *this = std::move(other);
+}
+
+FileWatcher& FileWatcher::operator=(FileWatcher&& other) noexcept {
+    if (this != &other) {
+        destroy();
+        folder_ = std::move(other.folder_);
+        fd_ = std::exchange(other.fd_, -1);
+        watches_ = std::move(other.watches_);
+        times_ = std::move(other.times_);
+        lastScan_ = std::exchange(other.lastScan_, 0);
+        other.folder_.clear();
+    }
+    return *this;
+}
+
+FileWatcher FileWatcher::make(const std::string& folder) {
+    FileWatcher object;
+    object.create(folder);
+    return object;
+}
+
+void FileWatcher::create(const std::string& folder) {
+
+    destroy();
+
+    std::error_code ec;
+    if (!fs::is_directory(folder, ec)) {
+        throw std::runtime_error(Format::str("failed to watch folder: ", folder.c_str()));
+    }
+
+    folder_ = folder;
+
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0) {
+        addWatches(fs::path(folder_));
+        return;
+    }
+#endif
+
+    // baseline without reporting, only later writes are changes
+    scan(nullptr);
+}
+
+void FileWatcher::destroy() {
+
+#ifdef __linux__
+    if (fd_ >= 0) {
+        ::close(fd_); // removes all watches
+    }
+#endif
+
+    fd_ = -1;
+    folder_.clear();
+    watches_.clear();
+    times_.clear();
+    lastScan_ = 0;
+}
+
+void FileWatcher::addWatches(const fs::path& folder) {
+
+#ifdef __linux__
+    auto wd = inotify_add_watch(fd_, folder.string().c_str(), WATCH_MASK);
+    if (wd < 0) return;
+
+    auto relative = fs::relative(folder, folder_).generic_string();
+    watches_[wd] = ("." == relative) ? std::string() : relative;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(folder, ec)) {
+        if (entry.is_directory(ec)) {
+            addWatches(entry.path());
+        }
+    }
+#else
+    (void) folder;
+#endif
+}
+
+std::vector<std::string> FileWatcher::poll() {
+
+    std::vector<std::string> changes;
+
+    if (!isWatching()) return changes;
+
+    if (isPolling()) {
+        scan(&changes);
+    } else {
+        readEvents(changes);
+    }
+
+    return changes;
+}
+
+void FileWatcher::readEvents(std::vector<std::string>& changes) {
+
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+
+    for (;;) {
+        auto size = ::read(fd_, buffer, sizeof(buffer));
+        if (size <= 0) break; // EAGAIN, nothing left to read
+
+        for (ssize_t offset = 0; offset < size; ) {
+            auto event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += (ssize_t) (sizeof(struct inotify_event) + event->len);
+
+            auto it = watches_.find(event->wd);
+            if (it == watches_.end() || 0 == event->len) continue;
+
+            std::string filename = it->second.empty() ? event->name : it->second + "/" + event->name;
+
+            if (0 != (event->mask & IN_ISDIR)) {
+                // new sub folders are watched as well, files written into
+                // them before the watch was added are missed
+                if (0 != (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    addWatches(fs::path(folder_) / filename);
+                }
+                continue;
+            }
+
+            if (0 != (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+                addChange(changes, std::move(filename));
+            }
+        }
+    }
+#else
+    (void) changes;
+#endif
+}
+
+void FileWatcher::scan(std::vector<std::string>* changes) {
+
+    auto now = Clock::getTime();
+    if (nullptr != changes && now - lastScan_ < SCAN_INTERVAL) return;
+    lastScan_ = now;
+
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(folder_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+
+        auto time = it->last_write_time(ec);
+        if (ec) continue;
+
+        auto filename = fs::relative(it->path(), folder_).generic_string();
+
+        auto& known = times_[filename];
+        if (known != time) {
+            if (nullptr != changes && known != fs::file_time_type{}) {
+                addChange(*changes, filename);
+            }
+            known = time;
+        }
+    }
+}
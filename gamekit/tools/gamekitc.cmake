@@ -11,17 +11,47 @@ find_package (Python COMPONENTS Interpreter)
 set(GAMEKITC_PYTHON_EXECUTABLE ${Python_EXECUTABLE} CACHE INTERNAL "")
 set(GAMEKITC_EXECUTABLE ${CMAKE_SOURCE_DIR}/gamekit/tools/gamekitc.py CACHE INTERNAL "")
 
+# resources are written to a memory mapped pack file next to the executable,
+# embedding them as byte arrays makes large asset sets slow to compile
+option(GAMEKIT_EMBED_RESOURCES "Compile resources into the executable" OFF)
+
+# development builds watch the resource sources, changed shaders and images
+# are compiled again and replaced while the application is running
+option(GAMEKIT_HOT_RELOAD "Reload changed resources from the source folder" OFF)
+
 function(compile_resources TARGET)
+    if (GAMEKIT_EMBED_RESOURCES)
+        set(GAMEKITC_OPTIONS --embed)
+        set(GAMEKITC_BYPRODUCTS ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}.h)
+    else()
+        set(GAMEKITC_OPTIONS)
+        set(GAMEKITC_BYPRODUCTS ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}.h ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}.gkpak)
+    endif()
     add_custom_command(
         OUTPUT ${TARGET}.cpp
+        BYPRODUCTS ${GAMEKITC_BYPRODUCTS}
         DEPFILE ${TARGET}.d
         COMMAND
             ${GAMEKITC_PYTHON_EXECUTABLE} ${GAMEKITC_EXECUTABLE}
+            ${GAMEKITC_OPTIONS}
             ${CMAKE_CURRENT_SOURCE_DIR}
             ${CMAKE_CURRENT_BINARY_DIR}
             ${TARGET}
     )
     target_sources(${TARGET} PRIVATE ${TARGET}.cpp)
+    target_include_directories(${TARGET} PUBLIC ${CMAKE_CURRENT_BINARY_DIR})   # generated ids header
+    if (GAMEKIT_HOT_RELOAD)
+        target_compile_definitions(${TARGET} INTERFACE GAMEKIT_RESOURCE_FOLDER="${CMAKE_CURRENT_SOURCE_DIR}")
+    endif()
+endfunction()
+
+function(deploy_resources TARGET RESOURCES)
+    if (NOT GAMEKIT_EMBED_RESOURCES)
+        get_target_property(RESOURCES_DIR ${RESOURCES} BINARY_DIR)
+        add_custom_command(TARGET ${TARGET} POST_BUILD
+            COMMAND ${CMAKE_COMMAND} -E copy_if_different ${RESOURCES_DIR}/${RESOURCES}.gkpak $<TARGET_FILE_DIR:${TARGET}>
+        )
+    endif()
 endfunction()
 
 function(export_folder FOLDERNAME)
@@ -8,20 +8,54 @@ import sys
 import os
 import os.path
 import getopt
+import io
+import json
+import hashlib
+import functools
+import concurrent.futures
 from pathlib import Path
 import subprocess
 
+import pngio
+import texenc
+import gkpack
+
 VERBOSE = False
 
 FILENAME_FILTER = [ "CMakeLists.txt" ]
 EXTENSION_FILTER = [ ".cpp", ".inc", ".c", ".h" ]
-SHADER_EXTENSIONS = [ ".vert", ".frag", ".shader" ]
+SHADER_EXTENSIONS = [ ".vert", ".frag", ".comp", ".shader" ]
+
+ATLAS_SUFFIX = ".atlas"     # folders packed into texture atlas pages
+ATLAS_PAGE_SIZE = 2048
+ATLAS_PADDING = 2           # edge pixels are repeated into the padding
+
+TEXTURE_SUFFIX = ".gktx"    # block compressed with mip chain, see texenc.py
+compress_textures = True
+
+IDS_NAMESPACE = "resource_ids"  # generated header of constexpr resource ids
+
+PACK_SUFFIX = ".gkpak"      # indexed binary pack, mapped at runtime, see gkpack.py
+embed_resources = False     # hex arrays compiled into the executable instead
+
+# values of gamekit::ResourceType
+RESOURCE_TYPES = {
+    "Unknown": 0x0,
+    "Data": 0x1,
+    "Text": 0x2,
+    "Bitmap": 0x3,
+    "VertexShader": 0x4,
+    "FragmentShader": 0x5,
+    "ComputeShader": 0x6,
+    "Atlas": 0x7,
+    "CompressedBitmap": 0x8
+}
 
 MAX_LINE_LENGTH = 120
-HEXCHARS = "0123456789abcdef"
 
 GLSLC_ENV = "vulkan1.2"
-GLSLC_FORMAT = "num"
+GLSLC_FORMAT_EMBED = "num"
+GLSLC_FORMAT_PACK = "bin"
 
 INDIVIDUAL_DEPENDS_FILE_ENABLED = False
 
@@ -30,9 +64,21 @@ glslc_executable = None
 
 descriptors = []
 
+MANIFEST_SUFFIX = ".manifest.json"  # content keys of the compiled outputs
+MANIFEST_VERSION = 1
+
+jobs_count = os.cpu_count() or 1
+jobs = []                   # (function name, args, output, key), run by the process pool
+finalizers = []             # run in walk order after all jobs completed
+previous_manifest = {}
+current_manifest = {}
+
 def usage():
-    print("Usage: gamekitc SOURCE TARGET [NAME]")
+    print("Usage: gamekitc [--no-compress] [--embed] [--jobs=N] SOURCE TARGET [NAME]")
     print("")
+    print("--no-compress : Keep png images, decoded at runtime")
+    print("--embed       : Compile resources into the executable instead of a pack file")
+    print("--jobs, -j    : Number of parallel jobs, defaults to the cpu count")
     print("SOURCE      : Source directory")
     print("TARGET      : Target directory")
     print("NAME        : Target name")
@@ -64,9 +110,6 @@ def get_descriptors():
     global descriptors
     return descriptors
 
-def format_byte(value):
-    return "0x" + HEXCHARS[int(value/16)] + HEXCHARS[int(value%16)]
-
 def is_ignored(filePath):
     if filePath.name in FILENAME_FILTER:
         return True
@@ -77,6 +120,20 @@ def is_ignored(filePath):
 def is_shader(filePath):
     return filePath.suffix in SHADER_EXTENSIONS
 
+def is_texture(filePath):
+    return compress_textures and filePath.suffix == ".png"
+
+def resource_type(suffix):
+    '''Name of the gamekit resource type of a descriptor suffix'''
+    if suffix == ".frag": return "FragmentShader"
+    if suffix == ".vert": return "VertexShader"
+    if suffix == ".comp": return "ComputeShader"
+    if suffix == ".png": return "Bitmap"
+    if suffix == TEXTURE_SUFFIX: return "CompressedBitmap"
+    if suffix == ".txt": return "Text"
+    if suffix == ATLAS_SUFFIX: return "Atlas"
+    return "Unknown"
+
 def create_folder(folder):
     if os.path.isdir(folder):
         return
@@ -90,41 +147,18 @@ def get_output_filename(source, output_folder, extension):
 
 def binc(source_file, output_file, depends_file):
     '''Convert binary file to C/C++ byte array'''
-    buffer_size = 4096
-    out_file = open(output_file, "w")
     with open(source_file, "rb") as in_file:
-        buffer = b''
-        avail = 0
-        ofs = 0
-        done = False
-        line = ""
-        while not done:
-            if avail < 1:
-                buffer = in_file.read(buffer_size)
-                if not buffer:
-                    break
-                avail = len(buffer)
-                ofs = 0
-
-            b = buffer[ofs]
-            ofs += 1
-            avail -= 1
-
-            line += format_byte(b) + ","
-            if len(line) >= MAX_LINE_LENGTH:
-                out_file.write(line)
-                out_file.write("\n")
-                line = ""
-
-    if len(line) >= 0:
-        out_file.write(line)
-
-    out_file.close()
+        data = in_file.read()
+
+    bytes_per_line = MAX_LINE_LENGTH // 5 # "0xnn,"
+    lines = []
+    for ofs in range(0, len(data), bytes_per_line):
+        lines.append("".join(f"0x{b:02x}," for b in data[ofs:ofs+bytes_per_line]))
+
+    write_if_changed(output_file, "\n".join(lines))
 
     if (None != depends_file and len(depends_file) > 0):
-        dep_file = open(depends_file, "w")
-        dep_file.write(f"{output_file}: {source_file}\n")
-        dep_file.close()
+        write_if_changed(depends_file, f"{output_file}: {source_file}\n")
 
     return
 
@@ -134,7 +168,7 @@ def glslc(source_file, output_file, depends_file):
     args = [
         glslc_executable,
         f"--target-env={GLSLC_ENV}",
-        f"-mfmt={GLSLC_FORMAT}"
+        f"-mfmt={GLSLC_FORMAT_EMBED if embed_resources else GLSLC_FORMAT_PACK}"
     ]
 
     if (None != depends_file and len(depends_file) > 0):
@@ -147,20 +181,106 @@ def glslc(source_file, output_file, depends_file):
         str(source_file)
     ])
 
-    subprocess.run(args)
-
-def needs_update(input, output):
-
-    if not os.path.exists(output):
-        return True
-
-    istat = os.stat(input)
-    ostat = os.stat(output)
-
-    if istat.st_mtime > ostat.st_mtime:
-        return True
+    result = subprocess.run(args)
+    if result.returncode != 0:
+        raise RuntimeError(f"glslc failed with exit code {result.returncode}")
+
+def write_if_changed(filename, content):
+    '''Write text or bytes, an unchanged file keeps its timestamp'''
+
+    mode = "b" if isinstance(content, (bytes, bytearray)) else ""
+
+    if os.path.exists(filename):
+        with open(filename, "r" + mode) as f:
+            if f.read() == content:
+                return False
+
+    with open(filename, "w" + mode) as f:
+        f.write(content)
+
+    return True
+
+def content_key(files, *settings):
+    '''Hash of the input files and the settings that produce an output'''
+    h = hashlib.sha256()
+    for setting in settings:
+        h.update(repr(setting).encode("utf-8") + b'\0')
+    for filename in files:
+        with open(filename, "rb") as f:
+            h.update(f.read())
+    return h.hexdigest()
+
+@functools.cache
+def tools_key():
+    '''Hash of the encoders, textures are rebuilt when they change'''
+    folder = Path(__file__).parent
+    return content_key([folder / "pngio.py", folder / "texenc.py"])
+
+def load_manifest(manifest_file):
+    '''Read the content keys of the previous run'''
+    global previous_manifest
+    previous_manifest = {}
+    try:
+        with open(manifest_file, "r") as f:
+            manifest = json.load(f)
+        if manifest.get("version") == MANIFEST_VERSION:
+            previous_manifest = manifest.get("outputs", {})
+    except (OSError, ValueError):
+        pass # missing or broken, everything is rebuilt
+
+def save_manifest(manifest_file):
+    '''Write the content keys of the outputs that are up to date'''
+    manifest = { "version": MANIFEST_VERSION, "outputs": current_manifest }
+    write_if_changed(manifest_file, json.dumps(manifest, indent=1, sort_keys=True) + "\n")
+
+def schedule(function_name, args, output, key, label):
+    '''Queue a compile job unless the output was built from the same content'''
+    if os.path.exists(output) and previous_manifest.get(output) == key:
+        if VERBOSE: print(f"no update: {output}")
+        current_manifest[output] = key
+        return
+    print(label)
+    jobs.append( (function_name, args, output, key) )
 
-    return False
+def run_job(settings, function_name, args):
+    '''Process pool entry, workers do not inherit the globals on every platform'''
+    global glslc_executable
+    global embed_resources
+    global compress_textures
+    glslc_executable, embed_resources, compress_textures = settings
+    globals()[function_name](*args)
+
+def run_jobs():
+    '''Run the queued jobs, returns False if any failed'''
+
+    settings = (glslc_executable, embed_resources, compress_textures)
+    failed = False
+
+    if jobs_count <= 1 or len(jobs) <= 1:
+        for function_name, args, output, key in jobs:
+            try:
+                run_job(settings, function_name, args)
+                current_manifest[output] = key
+            except Exception as e:
+                print(f"{args[0]}: {e}")
+                failed = True
+    else:
+        with concurrent.futures.ProcessPoolExecutor(max_workers=min(jobs_count, len(jobs))) as executor:
+            futures = {}
+            for function_name, args, output, key in jobs:
+                futures[executor.submit(run_job, settings, function_name, args)] = (args[0], output, key)
+            for future in concurrent.futures.as_completed(futures):
+                source, output, key = futures[future]
+                try:
+                    future.result()
+                    current_manifest[output] = key
+                except Exception as e:
+                    print(f"{source}: {e}")
+                    failed = True
+
+    jobs.clear()
+
+    return not failed
 
 def compile_shader(source, output, depends):
     '''Compile shader file using glslc'''
@@ -168,6 +288,17 @@ def compile_shader(source, output, depends):
     glslc(source, output, depends)
     return
 
+def compile_texture(source, output, depends):
+    '''Compress png file to block compressed texture'''
+    if VERBOSE: print(f"compiling texture {source}")
+    if embed_resources:
+        texture_file = output.removesuffix(".inc") + TEXTURE_SUFFIX
+        texenc.write(texture_file, pngio.read(source))
+        binc(texture_file, output, depends)
+    else:
+        texenc.write(output, pngio.read(source))
+    return
+
 def compile_data(source, output, depends):
     '''Compile data file'''
     if VERBOSE: print(f"compiling data {source}")
@@ -182,22 +313,33 @@ def process_file(source, base_input_folder, output_folder, base_output_folder):
     path = Path(source)
 
     create_folder(output_folder)
-    output = get_output_filename(path, output_folder, ".inc")
     depends = None # get_output_filename(path, output_folder, ".d")
 
-    if needs_update(path, output):
-        print(path.name)
-        if is_shader(path):
-            compile_shader(path, output, depends)
-        else:
-            compile_data(path, output, depends)
+    if embed_resources:
+        output = get_output_filename(path, output_folder, ".inc")
+    elif is_shader(path):
+        output = get_output_filename(path, output_folder, ".spv")
+    elif is_texture(path):
+        output = get_output_filename(path, output_folder, TEXTURE_SUFFIX)
     else:
-        if VERBOSE: print(f"no update: {path} {output}")
+        output = os.path.normpath(str(path)) # packed straight from the source
+
+    if is_shader(path):
+        key = content_key([path], "shader", GLSLC_ENV, embed_resources)
+        schedule("compile_shader", (path, output, depends), output, key, path.name)
+    elif is_texture(path):
+        key = content_key([path], "texture", tools_key(), embed_resources)
+        schedule("compile_texture", (path, output, depends), output, key, path.name)
+    elif embed_resources:
+        key = content_key([path], "data", MAX_LINE_LENGTH)
+        schedule("compile_data", (path, output, depends), output, key, path.name)
 
     rel_input = os.path.relpath(path, base_input_folder)
     rel_output = os.path.relpath(output, base_output_folder)
 
-    add_descriptor(path, rel_input, output, rel_output, path.suffix)
+    suffix = TEXTURE_SUFFIX if is_texture(path) else path.suffix
+
+    finalizers.append(functools.partial(add_descriptor, path, rel_input, output, rel_output, suffix))
 
 def write_stamp(stamp_file):
     '''Write stamp file'''
@@ -218,7 +360,7 @@ def write_depends(depends_file, target, descriptor_file):
     if not folder.exists:
         os.makedirs(folder)
 
-    f = open(depends_file, "w")
+    f = io.StringIO()
 
     if len(descriptors) > 0:
         f.write(f"{target}:")
@@ -228,11 +370,13 @@ def write_depends(depends_file, target, descriptor_file):
         f.write("\n")
 
         for descriptor in descriptors:
+            if os.path.normpath(descriptor[2]) == os.path.normpath(descriptor[0]):
+                continue # source file packed as is
             file_target = str(descriptor[3]).replace(' ', '\\ ')
             file_source = str(descriptor[0]).replace('\\', '/').replace(' ', '\\ ')
             f.write(f"{file_target}: {file_source}\n")
 
-    f.close()
+    write_if_changed(depends_file, f.getvalue())
 
 
 def write_descriptor(descriptor_file):
@@ -243,7 +387,7 @@ def write_descriptor(descriptor_file):
     if not folder.exists:
         os.makedirs(folder)
 
-    f = open(descriptor_file, "w")
+    f = io.StringIO()
 
     f.write("//\n")
     f.write("// GENERATED\n")
@@ -262,7 +406,7 @@ def write_descriptor(descriptor_file):
         name = descriptor[1].replace('\\', '/').lower()
         f.write(f"// {name}\n")
 
-        if suffix == ".frag" or suffix == ".vert":
+        if suffix == ".frag" or suffix == ".vert" or suffix == ".comp":
             f.write(f"static const uint32_t data{idx}[] = {{\n")
         else:
             f.write(f"static const uint8_t data{idx}[] = {{\n")
@@ -279,13 +423,7 @@ def write_descriptor(descriptor_file):
     f.write("\nstatic const std::vector<gamekit::ResourceDescriptor> descriptors = {\n")
     for descriptor in descriptors:
 
-        typename = "Unknown"
-
-        suffix = descriptor[4]
-        if suffix == ".frag": typename = "FragmentShader"
-        elif suffix == ".vert": typename = "VertexShader"
-        elif suffix == ".png": typename = "Bitmap"
-        elif suffix == ".txt": typename = "Text"
+        typename = resource_type(descriptor[4])
 
         name = descriptor[1].replace('\\', '/').lower()
 
@@ -299,7 +437,207 @@ def write_descriptor(descriptor_file):
     f.write("    return descriptors;\n")
     f.write("}\n")
 
-    f.close()
+    write_if_changed(descriptor_file, f.getvalue())
+
+def resource_id(name):
+    '''64 bit FNV-1a of the resource name, see gamekit::makeResourceId'''
+    return gkpack.fnv1a(name)
+
+def identifier(name):
+    '''C++ identifier of a resource name'''
+    result = "".join(c if c.isalnum() else "_" for c in name)
+    if result[0].isdigit(): result = "_" + result
+    return result
+
+def write_ids(ids_file):
+    '''Write header with the ids of all resources'''
+    descriptors = get_descriptors()
+
+    ids = {}
+    for descriptor in descriptors:
+        name = descriptor[1].replace('\\', '/').lower()
+        ident = identifier(name)
+        if ident in ids and ids[ident] != name:
+            raise ValueError(f"resource names {ids[ident]} and {name} map to the same identifier {ident}")
+        ids[ident] = name
+
+    f = io.StringIO()
+
+    f.write("//\n")
+    f.write("// GENERATED\n")
+    f.write("//\n\n")
+    f.write("#pragma once\n\n")
+    f.write("#include \"gamekit/primitives.h\"\n\n")
+    f.write(f"namespace {IDS_NAMESPACE} {{\n")
+
+    for ident, name in sorted(ids.items()):
+        f.write(f"\n// {name}\n")
+        f.write(f"constexpr gamekit::ResourceId {ident} = 0x{resource_id(name):016x}ull;\n")
+
+    f.write("\n} // namespace\n")
+
+    # keeps the generator and the runtime hash in sync
+    if len(ids) > 0:
+        ident, name = sorted(ids.items())[0]
+        f.write(f"\nstatic_assert({IDS_NAMESPACE}::{ident} == gamekit::makeResourceId(\"{name}\"));\n")
+
+    write_if_changed(ids_file, f.getvalue())
+
+def write_pack(pack_file, descriptor_file):
+    '''Write resource pack and the descriptor file that maps it'''
+    descriptors = get_descriptors()
+
+    entries = []
+    for descriptor in descriptors:
+        resource_name = descriptor[1].replace('\\', '/').lower()
+        type_id = RESOURCE_TYPES[resource_type(descriptor[4])]
+        with open(descriptor[2], "rb") as f:
+            entries.append( (resource_name, type_id, f.read()) )
+
+    write_if_changed(pack_file, gkpack.encode(entries))
+
+    # the build folder is searched after the executable folder
+    pack_name = Path(pack_file).name
+    pack_folder = str(Path(pack_file).parent).replace('\\', '/')
+
+    f = io.StringIO()
+
+    f.write("//\n")
+    f.write("// GENERATED\n")
+    f.write("//\n\n")
+    f.write("#include \"gamekit/gamekit.h\"\n\n")
+    f.write("using namespace gamekit;\n\n")
+    f.write("#include <vector>\n")
+
+    f.write("\nconst std::vector<gamekit::ResourceDescriptor>& getResourceDescriptors() {\n")
+    f.write(f"    static const ResourcePack pack = ResourcePack::open(\"{pack_name}\", {{ \"{pack_folder}\" }});\n")
+    f.write("    return pack.descriptors();\n")
+    f.write("}\n")
+
+    write_if_changed(descriptor_file, f.getvalue())
+
+def pack_atlas(images):
+    '''Shelf pack images into pages, returns pages and frames'''
+
+    # tallest first keeps the shelves tight
+    items = sorted(images, key=lambda item: (-item[1].height, -item[1].width, item[0]))
+
+    pages = []
+    frames = []
+
+    for name, image in items:
+        w = image.width + 2 * ATLAS_PADDING
+        h = image.height + 2 * ATLAS_PADDING
+        if w > ATLAS_PAGE_SIZE or h > ATLAS_PAGE_SIZE:
+            raise ValueError(f"{name}: image exceeds atlas page size {ATLAS_PAGE_SIZE}")
+
+        page = pages[-1] if len(pages) > 0 else None
+
+        if page is not None and page["x"] + w > ATLAS_PAGE_SIZE:
+            # next shelf
+            page["y"] += page["shelf"]
+            page["x"] = 0
+            page["shelf"] = 0
+
+        if page is None or page["y"] + h > ATLAS_PAGE_SIZE:
+            page = { "x": 0, "y": 0, "shelf": 0, "width": 0, "height": 0, "placements": [] }
+            pages.append(page)
+
+        x = page["x"]
+        y = page["y"]
+        page["placements"].append( (name, image, x, y) )
+        page["x"] += w
+        page["shelf"] = max(page["shelf"], h)
+        page["width"] = max(page["width"], x + w)
+        page["height"] = max(page["height"], y + h)
+
+    result = []
+
+    for index, page in enumerate(pages):
+        width = 1
+        while width < page["width"]: width *= 2
+        height = 1
+        while height < page["height"]: height *= 2
+
+        atlas = pngio.Image(width, height)
+        for name, image, x, y in page["placements"]:
+            atlas.blit(image, x + ATLAS_PADDING, y + ATLAS_PADDING)
+            atlas.extrude(x + ATLAS_PADDING, y + ATLAS_PADDING, image.width, image.height, ATLAS_PADDING)
+            frames.append( (name, index, x + ATLAS_PADDING, y + ATLAS_PADDING, image.width, image.height) )
+
+        result.append(atlas)
+
+    frames.sort(key=lambda frame: frame[0])
+
+    return result, frames
+
+def compile_atlas(source, output_folder, rel_input, table_file, output):
+    '''Pack the images of an atlas folder into pages and a frame table'''
+
+    path = Path(source)
+    sources = sorted(path.rglob("*.png"))
+
+    images = []
+    for source_file in sources:
+        name = Path(os.path.relpath(source_file, path)).with_suffix("").as_posix().lower()
+        images.append( (name, pngio.read(source_file)) )
+
+    pages, frames = pack_atlas(images)
+
+    with open(table_file, "w") as f:
+        f.write("# gamekit atlas\n")
+        for index, page in enumerate(pages):
+            page_file = get_output_filename(path, output_folder, f".page{index}.png")
+            if compress_textures:
+                texenc.write(page_file + TEXTURE_SUFFIX, page)
+                if embed_resources: binc(page_file + TEXTURE_SUFFIX, page_file + ".inc", None)
+            else:
+                pngio.write(page_file, page)
+                if embed_resources: binc(page_file, page_file + ".inc", None)
+            f.write(f"page {rel_input.lower()}/page{index}.png {page.width} {page.height}\n")
+        for name, index, x, y, w, h in frames:
+            f.write(f"frame {name} {index} {x} {y} {w} {h}\n")
+
+    if embed_resources: binc(table_file, output, None)
+
+def add_atlas_descriptors(source, output_folder, base_output_folder, rel_input, table_file, output):
+    '''Add the pages listed in the frame table and the table itself'''
+
+    path = Path(source)
+
+    with open(table_file, "r") as f:
+        page_names = [ line.split()[1] for line in f if line.startswith("page ") ]
+
+    for index, page_name in enumerate(page_names):
+        page_output = get_output_filename(path, output_folder, f".page{index}.png")
+        if embed_resources: page_output += ".inc"
+        elif compress_textures: page_output += TEXTURE_SUFFIX
+        page_suffix = TEXTURE_SUFFIX if compress_textures else ".png"
+        add_descriptor(table_file, page_name, page_output, os.path.relpath(page_output, base_output_folder), page_suffix)
+
+    add_descriptor(table_file, rel_input, output, os.path.relpath(output, base_output_folder), ATLAS_SUFFIX)
+
+def process_atlas(source, base_input_folder, output_folder, base_output_folder):
+    '''Schedule packing an atlas folder'''
+
+    if VERBOSE: print(f"gamekitc process_atlas({source}, {output_folder}, {base_output_folder})")
+
+    path = Path(source)
+    sources = sorted(path.rglob("*.png"))
+
+    create_folder(output_folder)
+
+    rel_input = os.path.relpath(path, base_input_folder).replace('\\', '/')
+    table_file = get_output_filename(path, output_folder, ".txt")
+    output = get_output_filename(path, output_folder, ".inc") if embed_resources else table_file
+
+    # frame names come from the relative paths
+    names = [ Path(os.path.relpath(source_file, path)).as_posix() for source_file in sources ]
+    key = content_key(sources, "atlas", names, rel_input, ATLAS_PAGE_SIZE, ATLAS_PADDING, compress_textures, embed_resources, tools_key())
+
+    schedule("compile_atlas", (path, output_folder, rel_input, table_file, output), output, key, path.name)
+
+    finalizers.append(functools.partial(add_atlas_descriptors, path, output_folder, base_output_folder, rel_input, table_file, output))
 
 def process_folder(input_folder, base_input_folder, output_folder, base_output_folder):
     '''Process folder'''
@@ -308,11 +646,13 @@ def process_folder(input_folder, base_input_folder, output_folder, base_output_f
 
     create_folder(output_folder)
 
-    file_names = os.listdir(input_folder)
+    file_names = sorted(os.listdir(input_folder)) # stable generated files
     for filename in file_names:
         abs_input = os.path.normpath(os.path.join(input_folder, filename))
         source_path = Path(abs_input)
-        if source_path.is_dir():
+        if source_path.is_dir() and source_path.suffix == ATLAS_SUFFIX:
+            process_atlas(abs_input, base_input_folder, output_folder, base_output_folder)
+        elif source_path.is_dir():
             abs_output = os.path.normpath(os.path.join(output_folder, filename))
             process_folder(abs_input, base_input_folder, abs_output, base_output_folder)
         else:
@@ -334,13 +674,30 @@ def process(input, output, name):
         output = os.path.join(os.getcwd(), output)
     output = os.path.normpath(output)
 
+    manifest_file = os.path.normpath(os.path.join(output, name + MANIFEST_SUFFIX))
+    load_manifest(manifest_file)
+
     process_folder(input, input, output, output)
 
+    success = run_jobs()
+    save_manifest(manifest_file)
+    if not success:
+        sys.exit(1)
+
+    for finalizer in finalizers:
+        finalizer()
+
     stamp_file = os.path.normpath(os.path.join(output, name + ".stamp"))
     write_stamp(stamp_file)
 
+    ids_file = os.path.normpath(os.path.join(output, name + ".h"))
+    write_ids(ids_file)
+
     descriptor_file = os.path.normpath(os.path.join(output, name + ".cpp"))
-    write_descriptor(descriptor_file)
+    if embed_resources:
+        write_descriptor(descriptor_file)
+    else:
+        write_pack(os.path.normpath(os.path.join(output, name + PACK_SUFFIX)), descriptor_file)
 
     depends_file = os.path.normpath(os.path.join(output, name + ".d"))
     write_depends(depends_file, name, descriptor_file)
@@ -348,9 +705,14 @@ def process(input, output, name):
 
 def main():
     '''Main entry'''
+
+    global compress_textures
+    global embed_resources
+    global jobs_count
+
     check_setup()
     try:
-        opts, args = getopt.getopt(sys.argv[1:], "h:", ["help"])
+        opts, args = getopt.getopt(sys.argv[1:], "hj:", ["help", "no-compress", "embed", "jobs="])
     except getopt.GetoptError:
         usage()
         sys.exit(2)
@@ -364,6 +726,12 @@ def main():
         if o in ("-h", "--help"):
             usage()
             sys.exit()
+        elif o == "--no-compress":
+            compress_textures = False
+        elif o == "--embed":
+            embed_resources = True
+        elif o in ("-j", "--jobs"):
+            jobs_count = max(1, int(a))
 
     source = Path(args[0])
     if not source.exists or not os.path.isdir(source):
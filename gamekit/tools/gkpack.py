@@ -0,0 +1,85 @@
+#
+# Binary resource pack writer, standard library only
+#
+
+import struct
+
+PACK_MAGIC = b'GKPACK\x00\x00'
+PACK_VERSION = 1
+PACK_HEADER = "<8sIIIIQQQ"     # magic, version, entry count, slot count, reserved, entries, slots, names
+PACK_ENTRY = "<QQQIIII"        # name hash, offset, size, name offset, name size, type, reserved
+PACK_SLOT = "<I"               # entry index + 1, 0 is empty
+PACK_ALIGNMENT = 16            # blob alignment, spir-v needs 4
+
+FNV_OFFSET = 0xcbf29ce484222325
+FNV_PRIME = 0x100000001b3
+
+def fnv1a(name):
+    '''64 bit FNV-1a hash of the utf-8 name'''
+    h = FNV_OFFSET
+    for b in name.encode("utf-8"):
+        h = ((h ^ b) * FNV_PRIME) & 0xffffffffffffffff
+    return h
+
+def align(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+def encode(entries):
+    '''Encode list of (name, type, data) as resource pack, returns bytes'''
+
+    entries = sorted(entries, key=lambda entry: entry[0])
+
+    names = set()
+    for name, _, _ in entries:
+        if name in names:
+            raise ValueError(f"duplicate resource name {name}")
+        names.add(name)
+
+    # open addressing with linear probing, at most half full
+    slot_count = 1
+    while slot_count < len(entries) * 2:
+        slot_count *= 2
+
+    slots = [0] * slot_count
+    for index, (name, _, _) in enumerate(entries):
+        slot = fnv1a(name) & (slot_count - 1)
+        while slots[slot] != 0:
+            slot = (slot + 1) & (slot_count - 1)
+        slots[slot] = index + 1
+
+    name_table = bytearray()
+    name_offsets = []
+    for name, _, _ in entries:
+        name_offsets.append(len(name_table))
+        name_table.extend(name.encode("utf-8") + b'\x00')
+
+    entries_offset = struct.calcsize(PACK_HEADER)
+    slots_offset = entries_offset + len(entries) * struct.calcsize(PACK_ENTRY)
+    names_offset = slots_offset + slot_count * struct.calcsize(PACK_SLOT)
+    offset = align(names_offset + len(name_table), PACK_ALIGNMENT)
+
+    table = bytearray()
+    blobs = bytearray()
+    for index, (name, type_id, data) in enumerate(entries):
+        blob_offset = align(offset + len(blobs), PACK_ALIGNMENT)
+        blobs.extend(bytes(blob_offset - offset - len(blobs)))
+        blobs.extend(data)
+        name_size = len(name.encode("utf-8"))
+        table.extend(struct.pack(PACK_ENTRY, fnv1a(name), blob_offset, len(data), name_offsets[index], name_size, type_id, 0))
+
+    header = struct.pack(PACK_HEADER, PACK_MAGIC, PACK_VERSION, len(entries), slot_count, 0, entries_offset, slots_offset, names_offset)
+
+    result = bytearray(header)
+    result.extend(table)
+    for entry in slots:
+        result.extend(struct.pack(PACK_SLOT, entry))
+    result.extend(name_table)
+    result.extend(bytes(offset - len(result)))
+    result.extend(blobs)
+
+    return bytes(result)
+
+def write(filename, entries):
+    '''Write resource pack file'''
+    with open(filename, "wb") as f:
+        f.write(encode(entries))
@@ -0,0 +1,185 @@
+#
+# PNG reader and writer, standard library only
+#
+
+import struct
+import zlib
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+COLOR_GRAY = 0
+COLOR_RGB = 2
+COLOR_PALETTE = 3
+COLOR_GRAY_ALPHA = 4
+COLOR_RGBA = 6
+
+CHANNELS = { COLOR_GRAY: 1, COLOR_RGB: 3, COLOR_PALETTE: 1, COLOR_GRAY_ALPHA: 2, COLOR_RGBA: 4 }
+
+class Image:
+    '''RGBA image, 8 bit per channel, rows top to bottom'''
+
+    def __init__(self, width, height, pixels=None):
+        self.width = width
+        self.height = height
+        self.pixels = pixels if pixels is not None else bytearray(width * height * 4)
+
+    def blit(self, source, x, y):
+        '''Copy source image to position x, y'''
+        row_size = source.width * 4
+        for row in range(source.height):
+            src = row * row_size
+            dst = ((y + row) * self.width + x) * 4
+            self.pixels[dst:dst+row_size] = source.pixels[src:src+row_size]
+
+    def extrude(self, x, y, w, h, border):
+        '''Repeat the edge pixels of the rect x, y, w, h into a border around it'''
+        stride = self.width * 4
+        for row in range(y, y + h):
+            left = (row * self.width + x) * 4
+            right = (row * self.width + x + w - 1) * 4
+            for i in range(1, border + 1):
+                if x - i >= 0:
+                    self.pixels[left-i*4:left-i*4+4] = self.pixels[left:left+4]
+                if x + w - 1 + i < self.width:
+                    self.pixels[right+i*4:right+i*4+4] = self.pixels[right:right+4]
+        x0 = max(0, x - border)
+        x1 = min(self.width, x + w + border)
+        top = y * stride
+        bottom = (y + h - 1) * stride
+        for i in range(1, border + 1):
+            if y - i >= 0:
+                self.pixels[top-i*stride+x0*4:top-i*stride+x1*4] = self.pixels[top+x0*4:top+x1*4]
+            if y + h - 1 + i < self.height:
+                self.pixels[bottom+i*stride+x0*4:bottom+i*stride+x1*4] = self.pixels[bottom+x0*4:bottom+x1*4]
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa = abs(p - a)
+    pb = abs(p - b)
+    pc = abs(p - c)
+    if pa <= pb and pa <= pc: return a
+    if pb <= pc: return b
+    return c
+
+def unfilter(data, width, height, bpp):
+    '''Reverse the per-row filters of the decompressed image data'''
+    stride = width * bpp
+    result = bytearray(stride * height)
+    prev = bytearray(stride)
+    ofs = 0
+    for row in range(height):
+        filter_type = data[ofs]
+        line = bytearray(data[ofs+1:ofs+1+stride])
+        ofs += 1 + stride
+        if filter_type == 1:
+            for i in range(bpp, stride):
+                line[i] = (line[i] + line[i-bpp]) & 0xff
+        elif filter_type == 2:
+            for i in range(stride):
+                line[i] = (line[i] + prev[i]) & 0xff
+        elif filter_type == 3:
+            for i in range(stride):
+                left = line[i-bpp] if i >= bpp else 0
+                line[i] = (line[i] + ((left + prev[i]) >> 1)) & 0xff
+        elif filter_type == 4:
+            for i in range(stride):
+                left = line[i-bpp] if i >= bpp else 0
+                up_left = prev[i-bpp] if i >= bpp else 0
+                line[i] = (line[i] + paeth(left, prev[i], up_left)) & 0xff
+        elif filter_type != 0:
+            raise ValueError(f"invalid png filter type {filter_type}")
+        result[row*stride:(row+1)*stride] = line
+        prev = line
+    return result
+
+def read(filename):
+    '''Read png file, returns RGBA image'''
+
+    with open(filename, "rb") as f:
+        data = f.read()
+
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError(f"{filename}: not a png file")
+
+    ofs = 8
+    idat = bytearray()
+    palette = None
+    transparency = None
+    width = height = bit_depth = color_type = interlace = 0
+
+    while ofs < len(data):
+        length, chunk_type = struct.unpack(">I4s", data[ofs:ofs+8])
+        chunk = data[ofs+8:ofs+8+length]
+        ofs += 12 + length
+        if chunk_type == b'IHDR':
+            width, height, bit_depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif chunk_type == b'PLTE':
+            palette = chunk
+        elif chunk_type == b'tRNS':
+            transparency = chunk
+        elif chunk_type == b'IDAT':
+            idat.extend(chunk)
+        elif chunk_type == b'IEND':
+            break
+
+    if bit_depth not in (8, 16) or interlace != 0 or color_type not in CHANNELS:
+        raise ValueError(f"{filename}: unsupported png format (depth={bit_depth}, color={color_type}, interlace={interlace})")
+
+    channels = CHANNELS[color_type]
+    bytes_per_sample = bit_depth // 8
+    raw = unfilter(zlib.decompress(bytes(idat)), width, height, channels * bytes_per_sample)
+
+    if bytes_per_sample == 2:
+        raw = raw[0::2] # keep the high bytes
+
+    pixels = bytearray(width * height * 4)
+    num = width * height
+
+    if color_type == COLOR_RGBA:
+        pixels[:] = raw
+    elif color_type == COLOR_RGB:
+        pixels[0::4] = raw[0::3]
+        pixels[1::4] = raw[1::3]
+        pixels[2::4] = raw[2::3]
+        pixels[3::4] = b'\xff' * num
+    elif color_type == COLOR_GRAY:
+        pixels[0::4] = raw
+        pixels[1::4] = raw
+        pixels[2::4] = raw
+        pixels[3::4] = b'\xff' * num
+    elif color_type == COLOR_GRAY_ALPHA:
+        pixels[0::4] = raw[0::2]
+        pixels[1::4] = raw[0::2]
+        pixels[2::4] = raw[0::2]
+        pixels[3::4] = raw[1::2]
+    elif color_type == COLOR_PALETTE:
+        if palette is None:
+            raise ValueError(f"{filename}: missing png palette")
+        alpha = transparency or b''
+        lookup = []
+        for i in range(len(palette) // 3):
+            a = alpha[i] if i < len(alpha) else 0xff
+            lookup.append(bytes(palette[i*3:i*3+3]) + bytes([a]))
+        pixels = bytearray(b''.join(lookup[index] for index in raw))
+
+    return Image(width, height, pixels)
+
+def chunk(chunk_type, data):
+    return struct.pack(">I", len(data)) + chunk_type + data + struct.pack(">I", zlib.crc32(chunk_type + data) & 0xffffffff)
+
+def encode(image):
+    '''Encode RGBA image as png, returns bytes'''
+    stride = image.width * 4
+    raw = bytearray()
+    for row in range(image.height):
+        raw.append(0) # no filter
+        raw.extend(image.pixels[row*stride:(row+1)*stride])
+
+    header = struct.pack(">IIBBBBB", image.width, image.height, 8, COLOR_RGBA, 0, 0, 0)
+
+    return PNG_SIGNATURE + chunk(b'IHDR', header) + chunk(b'IDAT', zlib.compress(bytes(raw), 9)) + chunk(b'IEND', b'')
+
+def write(filename, image):
+    '''Write RGBA image to png file'''
+    with open(filename, "wb") as f:
+        f.write(encode(image))
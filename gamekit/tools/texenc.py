@@ -0,0 +1,186 @@
+#
+# Block compressed texture encoder, standard library only
+#
+
+import struct
+
+import pngio
+
+# vulkan format ids
+VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132
+VK_FORMAT_BC3_SRGB_BLOCK = 138
+
+# KTX2 style identifier, a gamekit texture is not a KTX2 file
+CONTAINER_MAGIC = b'\xabGKT 10\xbb\r\n\x1a\n'
+CONTAINER_HEADER = "<12sIIII"
+CONTAINER_LEVEL = "<QQ"
+
+def downsample(image):
+    '''Half size image by 2x2 box filter, odd edges are clamped'''
+    w = max(1, image.width // 2)
+    h = max(1, image.height // 2)
+    src = image.pixels
+    stride = image.width * 4
+    result = bytearray(w * h * 4)
+    max_x = image.width - 1
+    max_y = image.height - 1
+    dst = 0
+    for y in range(h):
+        row0 = min(y * 2, max_y) * stride
+        row1 = min(y * 2 + 1, max_y) * stride
+        for x in range(w):
+            c0 = min(x * 2, max_x) * 4
+            c1 = min(x * 2 + 1, max_x) * 4
+            for c in range(4):
+                result[dst+c] = (src[row0+c0+c] + src[row0+c1+c] + src[row1+c0+c] + src[row1+c1+c] + 2) >> 2
+            dst += 4
+    return pngio.Image(w, h, result)
+
+def mip_chain(image):
+    '''Image followed by its mip levels down to 1x1'''
+    levels = [image]
+    while levels[-1].width > 1 or levels[-1].height > 1:
+        levels.append(downsample(levels[-1]))
+    return levels
+
+def has_alpha(image):
+    return any(a != 0xff for a in image.pixels[3::4])
+
+def block_pixels(image, bx, by):
+    '''16 RGBA tuples of a 4x4 block, edges of small images are clamped'''
+    pixels = image.pixels
+    width = image.width
+    max_x = width - 1
+    max_y = image.height - 1
+    block = []
+    for y in range(4):
+        row = min(by + y, max_y) * width
+        for x in range(4):
+            ofs = (row + min(bx + x, max_x)) * 4
+            block.append(pixels[ofs:ofs+4])
+    return block
+
+def to565(r, g, b):
+    return ((r * 31 + 127) // 255) << 11 | ((g * 63 + 127) // 255) << 5 | ((b * 31 + 127) // 255)
+
+def from565(c):
+    r = (c >> 11) & 0x1f
+    g = (c >> 5) & 0x3f
+    b = c & 0x1f
+    return ((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))
+
+def encode_color_block(block):
+    '''BC1 color block, endpoints from the inset bounding box'''
+
+    min_r = min(p[0] for p in block)
+    min_g = min(p[1] for p in block)
+    min_b = min(p[2] for p in block)
+    max_r = max(p[0] for p in block)
+    max_g = max(p[1] for p in block)
+    max_b = max(p[2] for p in block)
+
+    # inset by 1/16 of the range, reduces the error of the outer colors
+    inset_r = (max_r - min_r) >> 4
+    inset_g = (max_g - min_g) >> 4
+    inset_b = (max_b - min_b) >> 4
+
+    # the box diagonal with the covariance sign of the block
+    cov_rg = cov_bg = 0
+    mean_r = (min_r + max_r) >> 1
+    mean_g = (min_g + max_g) >> 1
+    mean_b = (min_b + max_b) >> 1
+    for p in block:
+        dg = p[1] - mean_g
+        cov_rg += (p[0] - mean_r) * dg
+        cov_bg += (p[2] - mean_b) * dg
+
+    r0, r1 = max_r - inset_r, min_r + inset_r
+    g0, g1 = max_g - inset_g, min_g + inset_g
+    b0, b1 = max_b - inset_b, min_b + inset_b
+    if cov_rg < 0: r0, r1 = r1, r0
+    if cov_bg < 0: b0, b1 = b1, b0
+
+    c0 = to565(r0, g0, b0)
+    c1 = to565(r1, g1, b1)
+
+    if c0 == c1:
+        return struct.pack("<HHI", c0, c1, 0)
+
+    if c0 < c1:
+        # four color mode needs c0 > c1
+        c0, c1 = c1, c0
+
+    e0 = from565(c0)
+    e1 = from565(c1)
+    palette = [
+        e0,
+        e1,
+        tuple((2 * a + b + 1) // 3 for a, b in zip(e0, e1)),
+        tuple((a + 2 * b + 1) // 3 for a, b in zip(e0, e1))
+    ]
+
+    indices = 0
+    for i, p in enumerate(block):
+        best = 0
+        best_error = 1 << 30
+        for j, q in enumerate(palette):
+            error = (p[0] - q[0]) ** 2 + (p[1] - q[1]) ** 2 + (p[2] - q[2]) ** 2
+            if error < best_error:
+                best = j
+                best_error = error
+        indices |= best << (i * 2)
+
+    return struct.pack("<HHI", c0, c1, indices)
+
+def encode_alpha_block(block):
+    '''BC3 alpha block, eight interpolated values between min and max'''
+
+    alphas = [p[3] for p in block]
+    a0 = max(alphas)
+    a1 = min(alphas)
+
+    if a0 == a1:
+        return struct.pack("<BB6s", a0, a1, bytes(6))
+
+    palette = [a0, a1] + [((7 - i) * a0 + i * a1 + 3) // 7 for i in range(1, 7)]
+
+    indices = 0
+    for i, a in enumerate(alphas):
+        best = min(range(8), key=lambda j: abs(a - palette[j]))
+        indices |= best << (i * 3)
+
+    return struct.pack("<BB", a0, a1) + indices.to_bytes(6, "little")
+
+def encode_level(image, alpha):
+    '''Encode image as BC3 with alpha, BC1 otherwise'''
+    data = bytearray()
+    for by in range(0, image.height, 4):
+        for bx in range(0, image.width, 4):
+            block = block_pixels(image, bx, by)
+            if alpha:
+                data.extend(encode_alpha_block(block))
+            data.extend(encode_color_block(block))
+    return data
+
+def encode(image):
+    '''Encode image and mip chain as gamekit texture container, returns bytes'''
+
+    alpha = has_alpha(image)
+    vk_format = VK_FORMAT_BC3_SRGB_BLOCK if alpha else VK_FORMAT_BC1_RGB_SRGB_BLOCK
+
+    levels = [encode_level(level, alpha) for level in mip_chain(image)]
+
+    header_size = struct.calcsize(CONTAINER_HEADER) + len(levels) * struct.calcsize(CONTAINER_LEVEL)
+
+    header = struct.pack(CONTAINER_HEADER, CONTAINER_MAGIC, vk_format, image.width, image.height, len(levels))
+    offset = header_size
+    for level in levels:
+        header += struct.pack(CONTAINER_LEVEL, offset, len(level))
+        offset += len(level)
+
+    return header + b''.join(levels)
+
+def write(filename, image):
+    '''Write gamekit texture container file'''
+    with open(filename, "wb") as f:
+        f.write(encode(image))
@@ -3,6 +3,7 @@
  */
 
 #include "gamekit/gamekit.h"
+#include "hello_resources.h"
 
 #include <iostream>
 #include <cmath>
@@ -37,9 +38,9 @@ public:
         material_.setDepthWriting(false);
         material_.setBlendMode(BlendMode::Additive);
 
-        material_.addShader(resources.getShader("shaders/shader.vert"));
-        material_.addShader(resources.getShader("shaders/shader.frag"));
-        textureRef_ = material_.addTexture(resources.getTexture("bitmap.png"), 1);
+        material_.addShader(resources.getShader(resource_ids::shaders_shader_vert));
+        material_.addShader(resources.getShader(resource_ids::shaders_shader_frag));
+        textureRef_ = material_.addTexture(resources.getTexture(resource_ids::bitmap_png), 1);
 
         shaderParamsBuffer_ = Uniform<ShaderParams>::make(0);
         material_.addBuffer(shaderParamsBuffer_);
@@ -106,6 +107,7 @@ private:
 
 int main(int argc, const char* argv[]) {
     Application<Exec, DefaultResourceDescriptor> app("Hello", 800, 600, 120);
+    app.configure(argc, argv);
     app.run();
     return 0;
 }
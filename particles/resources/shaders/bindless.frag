@@ -0,0 +1,58 @@
+//
+// Fragment Shader
+//
+
+#version 450
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+const float PI = 3.1415926538;
+
+layout(std140, set=0, binding=0) uniform shader_params {
+    float resolution_x;
+    float resolution_y;
+    float x_min;
+    float x_max;
+    float y_min;
+    float y_max;
+    float time;
+    float time_delta;
+    int frame;
+} params;
+
+// device texture table, slot 0 is never written
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+layout (location = 0) in vertex_data {
+    vec4 position;
+    vec4 color;
+    vec2 textureCoord;
+    flat uint textureMask;  // texture table index
+    flat uint flags;
+} inputs;
+
+layout (location = 0) out vec4 oColor;
+
+vec4 calculateHighlight(in vec2 fragCoord) {
+    float distance_x = min(1.0, abs(fragCoord.x));
+    float distance_y = min(1.0, abs(fragCoord.y));
+
+    float distance = min(1.0, abs(fragCoord.x * fragCoord.y));
+    float intensity = pow(cos(distance * 3.1415 / 2.0 ), 100.0);
+
+    float d = intensity;
+
+    return vec4(d, d, d, 0.0);
+}
+
+void main() {
+    vec2 fragCoord = inputs.position.xy;
+    vec4 fragColor = inputs.color;
+    fragColor += calculateHighlight(fragCoord);
+
+    if (0x0 != inputs.textureMask) {
+        fragColor *= texture(textures[nonuniformEXT(inputs.textureMask)], inputs.textureCoord);
+    }
+
+    oColor = fragColor;
+}
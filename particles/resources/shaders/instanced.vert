@@ -0,0 +1,58 @@
+//
+// Vertex Shader (instanced quads)
+//
+
+#version 450
+
+layout(std140, set=0, binding=0) uniform shader_params {
+    float resolution_x;
+    float resolution_y;
+    float x_min;
+    float x_max;
+    float y_min;
+    float y_max;
+    float time;
+    float time_delta;
+    int frame;
+} params;
+
+layout (location = 0) in vec4 iRect;
+layout (location = 1) in vec4 iTextureRect;
+layout (location = 2) in vec4 iColor;
+layout (location = 3) in uint iTextureMask;
+layout (location = 4) in uint iFlags;
+
+layout (location = 0) out vertex_data {
+    vec4 position;
+    vec4 color;
+    vec2 textureCoord;
+    flat uint textureMask;
+    flat uint flags;
+} outputs;
+
+// two triangles per quad, same corner order as the indexed vertex queue
+const int CORNER_INDEX[6] = int[6](2, 1, 0, 0, 3, 2);
+const vec2 CORNERS[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main() {
+
+    vec2 corner = CORNERS[CORNER_INDEX[gl_VertexIndex % 6]];
+
+    float width = params.x_max - params.y_min; if (width == 0.0) width = 1.0;
+    float height = params.y_max - params.y_min; if (height == 0.0) height = 1.0;
+
+    vec2 position = iRect.xy + corner * iRect.zw;
+
+    float x = -1.0 + 2.0 * (position.x - params.x_min) / width;
+    float y = -1.0 + 2.0 * (position.y - params.y_min) / height;
+
+    vec4 pos = vec4(x, y, 0.0, 1.0);
+
+    outputs.position = pos;
+    outputs.textureCoord = iTextureRect.xy + corner * iTextureRect.zw;
+    outputs.color = iColor;
+    outputs.textureMask = iTextureMask;
+    outputs.flags = iFlags;
+
+    gl_Position = pos;
+}
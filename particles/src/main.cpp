@@ -2,18 +2,26 @@
  * Main module
  */
 
-#include "entity.h"
-
 #include "gamekit/gamekit.h"
+#include "particles_resources.h"
 
 #include <iostream>
-#include <cmath>
-#include <execution>
+#include <vector>
+#include <type_traits>
 
 using namespace gamekit;
 
 static const bool parallelUpdates = false;
-static const size_t numEntities = 500;
+static const bool streamingVertices = true;
+static const bool instancedQuads = true;
+static const bool gpuParticles = false;
+static const bool bindlessTextures = false;
+static const size_t numParticles = 500;
+static const int tickRate = 60;                 // fixed simulation rate, drawn interpolated
+static const bool simulationThread = false;
+
+// one 48 byte instance per quad instead of four vertices and six indices
+using Batch = std::conditional_t<instancedQuads, QuadInstanceBatch, QuadBatch>;
 
 struct ShaderParams {
     float resolution_x;
@@ -27,6 +35,15 @@ struct ShaderParams {
     int32_t frame;
 };
 
+// simulation state next to the instance records, see particles.comp
+struct ParticleState {
+    glm::vec2 velocity{0.0f, 0.0f};
+    glm::vec2 target{0.0f, 0.0f};
+    float time_to_live{0.0f};
+    uint32_t random{0x1};
+    uint32_t reserved[2]{0, 0};
+};
+
 class Exec {
 
 public:
@@ -34,31 +51,51 @@ public:
 
         auto& resources = api.resources();
 
+        // decoded in parallel on the workers instead of one by one on first use
+        resources.preload({ resource_ids::particle_png, resource_ids::particle2_png });
+
         material_ = Material::make();
 
         material_.setDepthTesting(false);
         material_.setDepthWriting(false);
         material_.setBlendMode(BlendMode::Additive);
 
-        material_.addShader(resources.getShader("shaders/shader.vert"));
-        material_.addShader(resources.getShader("shaders/shader.frag"));
-        material_.addTexture(resources.getTexture("particle.png"), 1);
-        material_.addTexture(resources.getTexture("particle2.png"), 2);
+        if constexpr (instancedQuads || gpuParticles) {
+            material_.setVertexLayout(VertexLayout::QuadInstance);
+            material_.addShader(resources.getShader(resource_ids::shaders_instanced_vert));
+        } else {
+            material_.addShader(resources.getShader(resource_ids::shaders_shader_vert));
+        }
+
+        if (bindlessTextures && api.isBindlessSupported()) {
+            // registered first, so the particle texture values 1 and 2 select them
+            auto& textureTable = api.textureTable();
+            textureTable.add(resources.getTexture(resource_ids::particle_png));
+            textureTable.add(resources.getTexture(resource_ids::particle2_png));
+            material_.setBindless(true);
+            material_.addShader(resources.getShader(resource_ids::shaders_bindless_frag));
+        } else {
+            material_.addShader(resources.getShader(resource_ids::shaders_shader_frag));
+            material_.addTexture(resources.getTexture(resource_ids::particle_png), 1);
+            material_.addTexture(resources.getTexture(resource_ids::particle2_png), 2);
+        }
 
         shaderParamsBuffer_ = Uniform<ShaderParams>::make(0);
         material_.addBuffer(shaderParamsBuffer_);
 
         api.addMaterial(material_);
 
-        spriteBatch_ = QuadBatch::make(numEntities);
-
-        for (auto& entity : entities_) {
-            entity.initialize(0);
-            if constexpr (parallelUpdates) {
-                entity.batchIndex = spriteBatch_.reserve();
-            }
+        if constexpr (gpuParticles) {
+            initGpuParticles(api);
+            return;
         }
 
+        spriteBatch_ = Batch::make(numParticles, streamingVertices);
+
+        bounds_ = glm::vec4(0.0f, 0.0f, api.metrics().width_f, api.metrics().height_f);
+        particles_ = ParticleSystem::make(numParticles, bounds_);
+        particles_.setParallel(parallelUpdates);
+
     }
 
     void onShutdown(Api& api) {
@@ -66,8 +103,40 @@ public:
 
     void onUpdate(Api& api) {
 
-        auto deltaTime = api.deltaTime();
-        auto absTime = api.absTime();
+        if constexpr (gpuParticles) {
+            return; // advanced by the compute dispatch of the frame, see onDraw
+        }
+
+        // fixed rate, see main(), only the simulation state is touched here.
+        // ticks may run on the simulation thread, the bounds come from onDraw
+        particles_.update(api.deltaTime(), bounds_);
+    }
+
+    void onDraw(Api& api) {
+        if constexpr (gpuParticles) {
+            // dispatched in Device::beginDraw(), the parameters are read when the frame is submitted
+            updateParams(api);
+            instanceStorage_.bind();
+            Device::globalInstance()->draw(6, 0, numParticles);
+            return;
+        }
+
+        // the swapchain may have been resized by the device, the next ticks see it
+        bounds_ = glm::vec4(0.0f, 0.0f, api.metrics().width_f, api.metrics().height_f);
+
+        updateParams(api);
+
+        // positions between the last two ticks, render and tick rate are independent
+        spriteBatch_.begin();
+        particles_.write(spriteBatch_, api.interpolation());
+        spriteBatch_.end();
+
+        // deferred, sorted and recorded at the end of the frame
+        spriteBatch_.submit(api.renderQueue(), material_);
+    }
+
+private:
+    void updateParams(Api& api) {
 
         float viewportWidth = api.metrics().width_f;
         float viewportHeight = api.metrics().height_f;
@@ -80,60 +149,68 @@ public:
         params.y_min = 0.0f;
         params.x_max = viewportWidth;
         params.y_max = viewportHeight;
-        params.time = absTime;
-        params.time_delta = deltaTime;
+        params.time = api.absTime();
+        params.time_delta = api.deltaTime();
         params.frame++;
         shaderParamsBuffer_.copy();
+    }
 
-        spriteBatch_.begin();
+    void initGpuParticles(Api& api) {
 
-        if constexpr (parallelUpdates) {
-            std::for_each(
-                std::execution::par_unseq,
-                entities_.begin(),
-                entities_.end(),
-                [&](auto&& entity)
-                {
-                    entity.update(deltaTime);
-                    spriteBatch_.store(
-                        entity.batchIndex,
-                        entity.position.x, entity.position.y,
-                        entity.size.x, entity.size.y,
-                        entity.color.r, entity.color.g, entity.color.b, entity.color.a,
-                        entity.texture_coords.x, entity.texture_coords.y, entity.texture_coords.z, entity.texture_coords.w,
-                        entity.texture_mask, entity.flags
-                    );
-                }
-            );
-        } else {
-            for (auto& entity : entities_) {
-                entity.update(deltaTime);
-                spriteBatch_.push(
-                    entity.position.x, entity.position.y,
-                    entity.size.x, entity.size.y,
-                    entity.color.r, entity.color.g, entity.color.b, entity.color.a,
-                    entity.texture_coords.x, entity.texture_coords.y, entity.texture_coords.z, entity.texture_coords.w,
-                    entity.texture_mask, entity.flags
-                );
-            }
+        // all particles start expired, the first dispatch respawns them
+        std::vector<QuadInstance> instances(numParticles);
+        std::vector<ParticleState> states(numParticles);
+        for (size_t i = 0; i < numParticles; i++) {
+            instances[i].setRect(0.0f, 0.0f, 24.0f, 24.0f);
+            instances[i].setTexcoords(0.0f, 0.0f, 1.0f, 1.0f);
+            states[i].random = (uint32_t) (i + 1) * 0x9e3779b9u | 0x1;
         }
 
-        spriteBatch_.end();
-    }
+        instanceStorage_ = ShaderStorageBuffer::makeDeviceLocal(1, sizeof(QuadInstance) * numParticles);
+        instanceStorage_.copy(instances.data());
 
-    void onDraw(Api& api) {
-        spriteBatch_.draw();
+        stateStorage_ = ShaderStorageBuffer::makeDeviceLocal(2, sizeof(ParticleState) * numParticles);
+        stateStorage_.copy(states.data());
+
+        computeMaterial_ = ComputeMaterial::make();
+        computeMaterial_.setShader(api.resources().getShader(resource_ids::shaders_particles_comp));
+        computeMaterial_.addBuffer(shaderParamsBuffer_);
+        computeMaterial_.addBuffer(instanceStorage_);
+        computeMaterial_.addBuffer(stateStorage_);
+        computeMaterial_.setWorkSize(numParticles, 256);
+
+        api.addComputeMaterial(computeMaterial_);
     }
 
 private:
     Material material_;
     Uniform<ShaderParams> shaderParamsBuffer_;
-    QuadBatch spriteBatch_;
-    std::array<Entity, numEntities> entities_;
+    Batch spriteBatch_;
+    ParticleSystem particles_;
+    glm::vec4 bounds_{0.0f};        // viewport, written by onDraw and read by the ticks
+
+private: // gpu simulation
+    ComputeMaterial computeMaterial_;
+    ShaderStorageBuffer instanceStorage_;
+    ShaderStorageBuffer stateStorage_;
 };
 
 int main(int argc, const char* argv[]) {
     Application<Exec, DefaultResourceDescriptor> app("Demo", 800, 600, 120);
+
+    if constexpr (!gpuParticles) {
+        app.setFixedTimestep(tickRate);
+        app.setSimulationThread(simulationThread);
+    }
+
+    app.configure(argc, argv);
+
+    // the gpu simulation steps once per frame in its compute dispatch and
+    // needs the frame time, command line tick rates do not apply to it
+    if constexpr (gpuParticles) {
+        app.setFixedTimestep(0);
+        app.setSimulationThread(false);
+    }
     app.run();
     return 0;
 }